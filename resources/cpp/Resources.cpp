@@ -132,6 +132,10 @@ time_t Resources::getResourceModified(Resource resource) {
   return 0;
 }
 
+bool Resources::getResourceFile(Resource resource, char * out, size_t size) {
+  return false;
+}
+
 #else
 
 std::string slurpStream(std::istream& in) {
@@ -171,6 +175,15 @@ time_t Resources::getResourceModified(Resource resource) {
   return 0;
 }
 
+bool Resources::getResourceFile(Resource resource, char * out, size_t size) {
+  const std::string & filename = ::getResourcePath(resource);
+  if (filename.size() >= size) {
+    return false;
+  }
+  strcpy(out, filename.c_str());
+  return true;
+}
+
 #endif
 
 
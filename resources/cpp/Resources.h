@@ -23,6 +23,9 @@ public:
   static Resources_EXPORT const Resource FRAGMENT_SHADERS[];
   static Resources_EXPORT const Resource LIB_SHADERS[];
   static Resources_EXPORT void getResourcePath(Resource resource, char * out, size_t size);
+  // The file the resource is read from.  Returns false if the resource is
+  // embedded in the binary instead.
+  static Resources_EXPORT bool getResourceFile(Resource resource, char * out, size_t size);
   static Resources_EXPORT time_t getResourceModified(Resource resource);
   static Resources_EXPORT size_t getResourceSize(Resource resource);
   static Resources_EXPORT void getResourceData(Resource resource, void * out);
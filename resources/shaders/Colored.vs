@@ -1,7 +1,7 @@
 #version 440
-
-layout (location = 0) uniform mat4 Projection = mat4(1);
-layout (location = 1) uniform mat4 ModelView = mat4(1);
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
 
 layout(location = 0) in vec3 Position;
 layout(location = 3) in vec4 Color;
@@ -10,6 +10,6 @@ layout(location = 5) in mat4 InstanceTransform;
 out vec4 vColor;
 
 void main() {
-  gl_Position = Projection * ModelView * vec4(Position, 1);
+  gl_Position = EyeProject(EyeModelView(ModelView) * vec4(Position, 1));
   vColor = Color;
 }
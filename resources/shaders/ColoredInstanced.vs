@@ -0,0 +1,15 @@
+#version 440
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
+
+layout(location = 0) in vec3 Position;
+layout(location = 3) in vec4 Color;
+layout(location = 5) in mat4 InstanceTransform;
+
+out vec4 vColor;
+
+void main() {
+  gl_Position = EyeProject(EyeModelView(ModelView) * InstanceTransform * vec4(Position, 1));
+  vColor = Color;
+}
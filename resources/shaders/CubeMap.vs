@@ -1,13 +1,13 @@
 #version 440
-
-layout (location = 0) uniform mat4 Projection = mat4(1);
-layout (location = 1) uniform mat4 ModelView = mat4(1);
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
 
 layout(location = 0) in vec3 Position;
 
 out vec3 texCoord;
 
 void main() {
-    gl_Position = Projection * mat4(mat3(ModelView)) * vec4(Position, 1.0);
+    gl_Position = EyeProject(mat4(mat3(EyeModelView(ModelView))) * vec4(Position, 1.0));
     texCoord = -Position;
 }
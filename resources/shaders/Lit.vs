@@ -1,8 +1,7 @@
 #version 440
-
-layout (location = 0) uniform mat4 Projection = mat4(1);
-layout (location = 1) uniform mat4 ModelView = mat4(1);
-layout (location = 4) uniform vec4 Color = vec4(1, 1, 1, 1);
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
 
 layout(location = 0) in vec4 Position;
 layout(location = 2) in vec3 Normal;
@@ -12,15 +11,17 @@ out vec4 vViewPosition;
 out vec4 vColor;
 
 void main() {
-    gl_Position = Projection * ModelView * Position;
+    mat4 ViewXfm = EyeModelView(ModelView);
+
+    gl_Position = EyeProject(ViewXfm * Position);
 
     // The normal in view space
-    vViewNormal = vec4(ModelView * vec4(Normal.xyz, 0)).xyz;
+    vViewNormal = vec4(ViewXfm * vec4(Normal.xyz, 0)).xyz;
 
     // The position in view space
-    vViewPosition = ModelView * Position;
+    vViewPosition = ViewXfm * Position;
 
-    vColor = Color;
+    vColor = DrawColor;
 
 }
 
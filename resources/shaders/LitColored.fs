@@ -1,11 +1,6 @@
 #version 440
-
-layout (location = 8) uniform vec4 LightAmbient = vec4(0.5, 0.5, 0.5, 1.0);
-layout (location = 9) uniform int LightCount = 0;
-layout (location = 10) uniform float ForceAlpha = 0;
-
-layout (location = 16) uniform vec3 LightPosition[8];
-layout (location = 24) uniform vec4 LightColor[8];
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
 
 in vec3 vViewNormal;
 in vec4 vViewPosition;
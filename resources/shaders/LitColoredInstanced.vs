@@ -1,34 +1,34 @@
 #version 440
-
-layout (location = 0) uniform mat4 Projection = mat4(1);
-layout (location = 1) uniform mat4 ModelView = mat4(1);
-
-uniform bool InstanceTransformActive = false;
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
 
 layout(location = 0) in vec4 Position;
 layout(location = 2) in vec3 Normal;
 layout(location = 3) in vec4 Color;
 layout(location = 5) in mat4 InstanceTransform;
+layout(location = 9) in vec4 InstanceColor;
 
 out vec3 vViewNormal;
 out vec4 vViewPosition;
 out vec4 vColor;
 
 void main() {
-    mat4 ViewXfm = ModelView;
+    mat4 ViewXfm = EyeModelView(ModelView);
+
+    // The vertex color
+    vColor = Color;
 
     if (InstanceTransformActive) {
         ViewXfm = ViewXfm * InstanceTransform;
+        vColor = InstanceColor;
     }
     
-    gl_Position = Projection * ViewXfm * Position;
+    gl_Position = EyeProject(ViewXfm * Position);
 
     // The normal in view space
     vViewNormal = vec4(ViewXfm * vec4(Normal.xyz, 0)).xyz;
 
     // The position in view space
     vViewPosition = ViewXfm * Position;
-
-    // The vertex color
-    vColor = Color;
 }
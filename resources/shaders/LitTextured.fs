@@ -1,10 +1,7 @@
 #version 440
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
 
-uniform vec4 Ambient;
-uniform vec4 LightPosition[8];
-uniform vec4 LightColor[8];
-uniform int LightCount = 0;
-uniform float ForceAlpha = 0;
 uniform sampler2D sampler;
 
 in vec3 vViewNormal;
@@ -15,7 +12,7 @@ out vec4 FragColor;
 vec4 DoLight()
 {
    vec3 normal = normalize(vViewNormal);
-   vec3 light = Ambient.rgb;
+   vec3 light = LightAmbient.rgb;
    float alpha = 1;
    for (int i = 0; i < int(LightCount); i++)
    {
@@ -0,0 +1,38 @@
+#version 440
+
+// Stretches the packed multi-resolution regions of an eye back over its
+// viewport.  Each axis is split in three, and each third maps linearly to
+// its packed column or row, so neighbouring regions stay neighbours and
+// filtering across their edges is seamless.
+uniform sampler2D multires;
+// The eye's split points, in [0, 1]: x0, x1, y0, y1
+layout(location = 4) uniform vec4 Splits;
+// Texture coordinates of the packed columns' edges, from left to right
+layout(location = 5) uniform vec4 PackedX;
+// And of the packed rows' edges, from bottom to top
+layout(location = 6) uniform vec4 PackedY;
+
+in vec2 vTexCoord;
+out vec4 fragColor;
+
+float remap(float t, float split0, float split1, vec4 packed) {
+  if (t < split0) {
+    return mix(packed.x, packed.y, t / split0);
+  }
+  if (t < split1) {
+    return mix(packed.y, packed.z, (t - split0) / (split1 - split0));
+  }
+  return mix(packed.z, packed.w, (t - split1) / (1.0 - split1));
+}
+
+void main() {
+  vec2 halfTexel = 0.5 / vec2(textureSize(multires, 0));
+  vec2 uv = vec2(
+    remap(vTexCoord.x, Splits.x, Splits.y, PackedX),
+    remap(vTexCoord.y, Splits.z, Splits.w, PackedY));
+  // Keep the filter inside this eye's packed area
+  uv = clamp(uv,
+    vec2(PackedX.x, PackedY.x) + halfTexel,
+    vec2(PackedX.w, PackedY.w) - halfTexel);
+  fragColor = texture(multires, uv);
+}
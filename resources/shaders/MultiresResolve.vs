@@ -0,0 +1,10 @@
+#version 440
+
+// A single triangle covering the viewport, with no vertex buffer
+out vec2 vTexCoord;
+
+void main() {
+  vec2 corner = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+  vTexCoord = corner;
+  gl_Position = vec4(corner * 2.0 - 1.0, 0.0, 1.0);
+}
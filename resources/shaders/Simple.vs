@@ -1,15 +1,13 @@
 #version 440
-
-layout (location = 0) uniform mat4 Projection = mat4(1);
-layout (location = 1) uniform mat4 ModelView = mat4(1);
-
-uniform vec4 Color = vec4(1, 1, 1, 1);
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
+#include "/shaders/Stereo.glsl"
 
 layout(location = 0) in vec3 Position;
 
 out vec4 vColor;
 
 void main() {
-  gl_Position = Projection * ModelView * vec4(Position, 1);
-  vColor = Color;
+  gl_Position = EyeProject(EyeModelView(ModelView) * vec4(Position, 1));
+  vColor = DrawColor;
 }
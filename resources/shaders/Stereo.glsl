@@ -0,0 +1,29 @@
+// Vertex shader helpers for single pass stereo.  When Camera.Stereo is
+// set every draw is instanced twice, even instances render the left eye
+// into the left half of a side by side target, and odd instances the
+// right eye into the right half.  GL_CLIP_DISTANCE0 must be enabled so
+// neither eye spills into the other's half.
+
+int StereoEye() {
+  return Stereo ? (gl_InstanceID & 1) : 0;
+}
+
+// The eye space transform for the current eye
+mat4 EyeModelView(mat4 modelView) {
+  return Stereo ? EyeOffset[StereoEye()] * modelView : modelView;
+}
+
+// Projects an eye space position and routes it to the current eye
+vec4 EyeProject(vec4 eyePosition) {
+  if (!Stereo) {
+    gl_ClipDistance[0] = 1.0;
+    return Projection * eyePosition;
+  }
+  int eye = StereoEye();
+  vec4 clip = EyeProjection[eye] * eyePosition;
+  // Squeeze x into the eye's half of the target
+  float side = (eye == 0) ? -1.0 : 1.0;
+  clip.x = (clip.x + side * clip.w) * 0.5;
+  gl_ClipDistance[0] = side * clip.x;
+  return clip;
+}
@@ -1,7 +1,8 @@
 #version 440
+#extension GL_ARB_shading_language_include : require
+#include "/shaders/Uniforms.glsl"
 
 uniform sampler2D Font;
-uniform vec4 Color;
 
 in vec2 vTexCoord;
 out vec4 FragColor;
@@ -27,5 +28,5 @@ void main()
    }
 
    // final color
-   FragColor = vec4(Color.rgb, a);
+   FragColor = vec4(DrawColor.rgb, a);
 }
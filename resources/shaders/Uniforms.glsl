@@ -0,0 +1,32 @@
+// Uniform blocks shared by every program.  The layouts must match the
+// std140 structs in src/Uniforms.h, and the bindings Layout::UniformBlock.
+
+#define MAX_LIGHTS 8
+
+// Written once per eye, or once per frame with single pass stereo
+layout(std140, binding = 0) uniform Camera {
+  mat4 Projection;
+  // World to eye space
+  mat4 View;
+  // Single pass stereo only.  ModelView is built from the left eye's
+  // view, and EyeOffset takes it to each eye's view.
+  mat4 EyeProjection[2];
+  mat4 EyeOffset[2];
+  bool Stereo;
+};
+
+// Written once per eye.  Positions are in eye space.
+layout(std140, binding = 1) uniform Lighting {
+  vec4 LightAmbient;
+  vec4 LightPosition[MAX_LIGHTS];
+  vec4 LightColor[MAX_LIGHTS];
+  int LightCount;
+};
+
+// Written for every draw call
+layout(std140, binding = 2) uniform Draw {
+  mat4 ModelView;
+  vec4 DrawColor;
+  bool InstanceTransformActive;
+  float ForceAlpha;
+};
@@ -0,0 +1,137 @@
+#include "Common.h"
+
+AssetLoader::AssetLoader(int threads) {
+  // Both of these are built on first use without locking, so make sure
+  // that happens here rather than in a race between workers
+  Platform::getResourcePath(GlUtils::PIECE_RESOURCES[0]);
+  MeshCache::getDirectory();
+
+  if (threads > 0) {
+    work.reset(new boost::asio::io_service::work(service));
+    for (int i = 0; i < threads; ++i) {
+      workers.create_thread([this, i] {
+        Profiler::setThreadName(Platform::format("Asset loader %d", i + 1));
+        service.run();
+      });
+    }
+  }
+}
+
+AssetLoader::~AssetLoader() {
+  work.reset();
+  workers.join_all();
+}
+
+int AssetLoader::defaultThreads() {
+  int cores = boost::thread::hardware_concurrency();
+  return std::max(1, cores - 1);
+}
+
+void AssetLoader::add(Task cpu, Task gl) {
+  ++total;
+  Task job = [this, cpu, gl] {
+    Task result = gl;
+    try {
+      Profiler::Zone zone("Asset load");
+      cpu();
+    } catch (const std::exception & error) {
+      // Fail on the GL thread, where someone is waiting on the result
+      std::string what = error.what();
+      result = [what] {
+        throw std::runtime_error(what);
+      };
+    }
+    withScopedLock(mutex, [&](const boost::mutex::scoped_lock &){
+      ready.push_back(result);
+    });
+    readyCondition.notify_one();
+  };
+
+  if (work) {
+    service.post(job);
+  } else {
+    job();
+  }
+}
+
+void AssetLoader::addProgram(Resource vertexResource, Resource fragmentResource) {
+  if (!includesAdded) {
+    includesAdded = true;
+    add(&GlUtils::preloadShaderIncludes, Task());
+  }
+  add([=] {
+    GlUtils::getShaderSource(vertexResource);
+    GlUtils::getShaderSource(fragmentResource);
+  }, [=] {
+    GlUtils::getProgram(vertexResource, fragmentResource);
+  });
+}
+
+void AssetLoader::addCubemap(Resource firstResource) {
+  add([=] {
+    GlUtils::preloadCubemapImages(firstResource);
+  }, [=] {
+    GlUtils::getCubemapTexture(firstResource);
+  });
+}
+
+void AssetLoader::addGeometry(Resource resource) {
+  // Holding the entry until the upload means getGeometry finds it in the
+  // MeshCache rather than loading it again
+  std::shared_ptr<CachedMeshPtr> cached(new CachedMeshPtr());
+  add([=] {
+    *cached = MeshCache::load(resource);
+  }, [=] {
+    GlUtils::getGeometry(resource);
+    cached->reset();
+  });
+}
+
+void AssetLoader::addSharedMeshes() {
+  // Each piece loads on its own worker, and the buffer is built once the
+  // last of them is ready
+  struct Pieces {
+    CachedMeshPtr meshes[Chess::PieceType::COUNT][SharedMesh::PIECE_LODS];
+    int remaining{ Chess::PieceType::COUNT };
+  };
+  std::shared_ptr<Pieces> pieces(new Pieces());
+  for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+    Resource resource = GlUtils::PIECE_RESOURCES[type];
+    add([=] {
+      for (int lod = 0; lod < SharedMesh::PIECE_LODS; ++lod) {
+        pieces->meshes[type][lod] = MeshCache::load(resource, &GlUtils::SHARED_MESH_LAYOUT, lod);
+      }
+    }, [=] {
+      if (0 == --pieces->remaining) {
+        GlUtils::getSharedMeshes();
+        for (int i = 0; i < Chess::PieceType::COUNT; ++i) {
+          for (int lod = 0; lod < SharedMesh::PIECE_LODS; ++lod) {
+            pieces->meshes[i][lod].reset();
+          }
+        }
+      }
+    });
+  }
+}
+
+void AssetLoader::finish(Progress progress) {
+  while (loaded < total) {
+    Task task;
+    {
+      boost::mutex::scoped_lock lock(mutex);
+      while (ready.empty()) {
+        readyCondition.wait(lock);
+      }
+      task = ready.front();
+      ready.pop_front();
+    }
+    if (task) {
+      Profiler::Zone zone("Asset upload");
+      task();
+    }
+    ++loaded;
+    if (progress) {
+      progress(loaded, total);
+    }
+  }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+// Loads assets ahead of their first use, so the first frames don't stall
+// on them.  The CPU side of each asset, decoding CTM meshes and PNGs and
+// reading shader sources, starts on a pool of worker threads as soon as
+// it's added.  finish runs the GL side of each on the calling thread, in
+// whatever order they become ready.
+//
+// With no threads the CPU work runs inline as each asset is added, which
+// matches the old serial loading, for comparison.
+class AssetLoader {
+public:
+  typedef boost::function<void()> Task;
+  // Called from finish after each asset is loaded
+  typedef boost::function<void(int loaded, int total)> Progress;
+
+  explicit AssetLoader(int threads = defaultThreads());
+  ~AssetLoader();
+
+  // See GlUtils::getProgram
+  void addProgram(Resource vertexResource, Resource fragmentResource);
+  // See GlUtils::getCubemapTexture
+  void addCubemap(Resource firstResource);
+  // See GlUtils::getGeometry
+  void addGeometry(Resource resource);
+  // See GlUtils::getSharedMeshes
+  void addSharedMeshes();
+
+  // Call on the GL thread.  Blocks until everything added so far is
+  // loaded.
+  void finish(Progress progress = Progress());
+
+  // One less than the core count, leaving a core for the GL thread
+  static int defaultThreads();
+
+private:
+  void add(Task cpu, Task gl);
+
+  boost::asio::io_service service;
+  std::unique_ptr<boost::asio::io_service::work> work;
+  boost::thread_group workers;
+
+  // GL tasks whose CPU side is done
+  boost::mutex mutex;
+  boost::condition_variable readyCondition;
+  std::deque<Task> ready;
+
+  int total{ 0 };
+  int loaded{ 0 };
+  bool includesAdded{ false };
+};
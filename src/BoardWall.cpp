@@ -0,0 +1,268 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+const float BoardWall::RADIUS = 2.5f;
+const float BoardWall::SPACING = 0.55f;
+
+static const GLbitfield PERSISTENT_FLAGS =
+  GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+BoardWall::BoardWall() {
+  memset(fences, 0, sizeof(fences));
+  memset(written, 0, sizeof(written));
+  for (int i = 0; i < BUFFER_COPIES; ++i) {
+    writtenViews[i] = 1;
+    writtenMeshes[i] = 0;
+  }
+}
+
+BoardWall::~BoardWall() {
+  for (int i = 0; i < BUFFER_COPIES; ++i) {
+    if (fences[i]) {
+      glDeleteSync(fences[i]);
+    }
+  }
+  if (mapped) {
+    instanceBuffer.Bind(Buffer::Target::Array);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    commandBuffer.Bind(Buffer::Target::DrawIndirect);
+    glUnmapBuffer(GL_DRAW_INDIRECT_BUFFER);
+  }
+}
+
+void BoardWall::setBoardCount(int count) {
+  count = std::min(std::max(count, 0), MAX_BOARDS);
+  if (count == boards.size()) {
+    return;
+  }
+  boards.resize(count);
+  layoutDirty = true;
+}
+
+void BoardWall::setBoard(int index, const Chess::Board & board) {
+  WallBoard & wallBoard = boards[index];
+  if (memcmp(&wallBoard.board, &board, sizeof(Chess::Board))) {
+    wallBoard.board = board;
+    ++wallBoard.version;
+  }
+}
+
+void BoardWall::map() {
+  size_t instanceBytes = sizeof(InstanceData) * MAX_BOARDS * SLOTS_PER_BOARD * BUFFER_COPIES;
+  instanceBuffer.Bind(Buffer::Target::Array);
+  glBufferStorage(GL_ARRAY_BUFFER, instanceBytes, nullptr, PERSISTENT_FLAGS);
+  instances = (InstanceData*)glMapBufferRange(GL_ARRAY_BUFFER, 0, instanceBytes, PERSISTENT_FLAGS);
+  NoBuffer().Bind(Buffer::Target::Array);
+
+  size_t commandBytes = sizeof(DrawElementsIndirectCommand) * MAX_BOARDS * COMMANDS_PER_BOARD * BUFFER_COPIES;
+  commandBuffer.Bind(Buffer::Target::DrawIndirect);
+  glBufferStorage(GL_DRAW_INDIRECT_BUFFER, commandBytes, nullptr, PERSISTENT_FLAGS);
+  commands = (DrawElementsIndirectCommand*)glMapBufferRange(GL_DRAW_INDIRECT_BUFFER, 0, commandBytes, PERSISTENT_FLAGS);
+  NoBuffer().Bind(Buffer::Target::DrawIndirect);
+
+  if (!instances || !commands) {
+    FAIL("Unable to map the board wall buffers");
+  }
+  mapped = true;
+}
+
+// Rows of boards stacked around the player's eye height, with the columns
+// bent around a cylinder so every board faces the player
+mat4 BoardWall::getBoardTransform(int index, int count) {
+  int columns = (int)ceil(sqrt((float)count));
+  int rows = (count + columns - 1) / columns;
+  int row = index / columns;
+  int column = index % columns;
+  float angle = ((columns - 1) / 2.0f - column) * (SPACING / RADIUS);
+  float height = ((rows - 1) / 2.0f - row) * SPACING;
+
+  MatrixStack m;
+  m.rotate(angle, GlUtils::Y_AXIS);
+  m.translate(vec3(0, height, -RADIUS));
+  // Stand the board up, with white at the bottom
+  m.rotate(PI / 2, GlUtils::X_AXIS);
+  return m.top();
+}
+
+void BoardWall::layout() {
+  int count = boards.size();
+  std::vector<InstanceData> boardInstances(count);
+  for (int i = 0; i < count; ++i) {
+    boards[i].transform = getBoardTransform(i, count);
+    boardInstances[i].transform = boards[i].transform;
+    boardInstances[i].color = vec4(1);
+    // Force a rewrite of the board's pieces in every region
+    ++boards[i].version;
+  }
+
+  if (count) {
+    boardInstanceBuffer.Bind(Buffer::Target::Array);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(InstanceData), &boardInstances[0], GL_STATIC_DRAW);
+    NoBuffer().Bind(Buffer::Target::Array);
+  }
+  layoutDirty = false;
+}
+
+void BoardWall::updateBounds(const MeshBuffer & meshes) {
+  Bounds bounds = PieceRenderer::getBoardBounds(meshes);
+  boardSpheres.clear();
+  for (size_t i = 0; i < boards.size(); ++i) {
+    boardSpheres.add(bounds, boards[i].transform);
+  }
+  boundsMeshes = meshes.version;
+}
+
+GLintptr BoardWall::instanceOffset() const {
+  return sizeof(InstanceData) * MAX_BOARDS * SLOTS_PER_BOARD * copy;
+}
+
+GLintptr BoardWall::commandOffset() const {
+  return sizeof(DrawElementsIndirectCommand) * MAX_BOARDS * COMMANDS_PER_BOARD * copy;
+}
+
+// Pieces are grouped by type within the board's slots, with one command
+// per type.  Empty types still get a command, with an instance count of 0,
+// so the command layout never changes.
+void BoardWall::writeBoard(int index) {
+  const WallBoard & wallBoard = boards[index];
+  MeshBuffer & meshes = GlUtils::getSharedMeshes();
+  GLuint firstSlot = index * SLOTS_PER_BOARD;
+  InstanceData * boardInstances = instances + (MAX_BOARDS * SLOTS_PER_BOARD * copy) + firstSlot;
+  DrawElementsIndirectCommand * boardCommands = commands + (MAX_BOARDS * COMMANDS_PER_BOARD * copy) + index * COMMANDS_PER_BOARD;
+
+  GLuint slot = 0;
+  for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+    GLuint typeStart = slot;
+    Chess::forEachSquare([&](int row, int col){
+      Chess::Piece piece = wallBoard.board.position[row][col];
+      if (piece && Chess::pieceType(piece) == type && slot < SLOTS_PER_BOARD) {
+        InstanceData & instance = boardInstances[slot++];
+        instance.transform = wallBoard.transform * PieceRenderer::getPieceTransform(row, col, piece);
+        instance.color = PieceRenderer::getPieceColor(piece);
+      }
+    });
+    boardCommands[type] = meshes.getCommand(SharedMesh::pieceLod(type, wallBoard.lod),
+      slot - typeStart, firstSlot + typeStart);
+  }
+  written[copy][index] = wallBoard.version;
+}
+
+void BoardWall::update(float pixelScale) {
+  if (!mapped) {
+    map();
+  }
+
+  // Everything submitted for the current region so far is covered by
+  // this fence, so it's safe to write again once it signals
+  if (fences[copy]) {
+    glDeleteSync(fences[copy]);
+  }
+  fences[copy] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+  copy = (copy + 1) % BUFFER_COPIES;
+  if (fences[copy]) {
+    GLenum result = glClientWaitSync(fences[copy], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (GL_TIMEOUT_EXPIRED == result) {
+      result = glClientWaitSync(fences[copy], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    glDeleteSync(fences[copy]);
+    fences[copy] = 0;
+  }
+
+  MeshBuffer & meshes = GlUtils::getSharedMeshes();
+  if (layoutDirty) {
+    layout();
+    updateBounds(meshes);
+  } else if (boundsMeshes != meshes.version) {
+    updateBounds(meshes);
+  }
+
+  // A level change rewrites the board in every region, like any other
+  // change to it
+  const mat4 & view = Stacks::modelview().top();
+  for (size_t i = 0; i < boards.size(); ++i) {
+    WallBoard & wallBoard = boards[i];
+    float pixels = PieceRenderer::getProjectedSize(view * wallBoard.transform, pixelScale);
+    int lod = PieceRenderer::selectLod(pixels, wallBoard.lod);
+    if (lod != wallBoard.lod) {
+      wallBoard.lod = lod;
+      ++wallBoard.version;
+    }
+  }
+
+  if (writtenViews[copy] != Geometry::viewCount || writtenMeshes[copy] != meshes.version) {
+    writtenViews[copy] = Geometry::viewCount;
+    writtenMeshes[copy] = meshes.version;
+    memset(written[copy], 0, sizeof(written[copy]));
+  }
+
+  for (size_t i = 0; i < boards.size(); ++i) {
+    if (written[copy][i] != boards[i].version) {
+      writeBoard(i);
+    }
+  }
+}
+
+void BoardWall::render() {
+  if (boards.empty()) {
+    return;
+  }
+
+  // Runs of neighbouring visible boards, as first board and count
+  std::vector<std::pair<int, int>> runs;
+  Culling::cull(boardSpheres, Stacks::modelview().top(), visible);
+  for (int i = 0; i < (int)boards.size(); ++i) {
+    if (!visible[i]) {
+      continue;
+    }
+    if (!runs.empty() && runs.back().first + runs.back().second == i) {
+      ++runs.back().second;
+    } else {
+      runs.push_back(std::make_pair(i, 1));
+    }
+  }
+  if (runs.empty()) {
+    return;
+  }
+
+  MeshBuffer & meshes = GlUtils::getSharedMeshes();
+  meshes.bind();
+  {
+    static const ProgramHandle program = GlUtils::getProgramHandle(
+      Resource::SHADERS_COLOREDINSTANCED_VS,
+      Resource::SHADERS_COLORED_FS);
+    Program & prog = GlUtils::getProgram(program);
+    prog.Use();
+    Uniforms::setDraw();
+    Geometry::bindInstances(boardInstanceBuffer);
+    for (size_t i = 0; i < runs.size(); ++i) {
+      meshes.drawInstanced(SharedMesh::CHESS_BOARD, runs[i].second, runs[i].first);
+    }
+  }
+
+  {
+    static const ProgramHandle program = GlUtils::getProgramHandle(
+      Resource::SHADERS_LITCOLOREDINSTANCED_VS,
+      Resource::SHADERS_LITCOLORED_FS);
+    Program & prog = GlUtils::getProgram(program);
+    prog.Use();
+    DrawBlock draw(Stacks::modelview().top());
+    draw.instanceTransformActive = 1;
+    Uniforms::setDraw(draw);
+
+    Geometry::bindInstances(instanceBuffer, instanceOffset());
+    commandBuffer.Bind(Buffer::Target::DrawIndirect);
+    for (size_t i = 0; i < runs.size(); ++i) {
+      GLintptr offset = commandOffset() +
+        runs[i].first * COMMANDS_PER_BOARD * sizeof(DrawElementsIndirectCommand);
+      ++Geometry::drawCalls;
+      glMultiDrawElementsIndirect(meshes.elementType, meshes.indexType,
+        (void*)offset, runs[i].second * COMMANDS_PER_BOARD, 0);
+    }
+    NoBuffer().Bind(Buffer::Target::DrawIndirect);
+  }
+
+  NoVertexArray().Bind();
+  NoProgram().Use();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+// Lays out a set of observed boards on an arc around the player and draws
+// every piece of every board with a single glMultiDrawElementsIndirect.
+//
+// The instance and command buffers are persistently mapped and split into
+// BUFFER_COPIES regions, so the CPU writes one region while the GPU reads
+// the others.  Each board owns a fixed slice of every region, and a slice
+// is only rewritten when that board has changed since the region last
+// held it.
+//
+// Each board picks a level of detail for its pieces from its distance,
+// see PieceRenderer::selectLod, so distant boards cost a fraction of the
+// triangles of near ones.  Boards outside the Culling views aren't drawn
+// at all.  The visible boards are drawn in runs of neighbours, since the
+// commands can't be rewritten between the draws of one frame.
+class BoardWall {
+public:
+  static const int MAX_BOARDS = 128;
+  static const int BUFFER_COPIES = 3;
+  // A board can never hold more than 32 pieces
+  static const int SLOTS_PER_BOARD = 32;
+  static const int COMMANDS_PER_BOARD = Chess::PieceType::COUNT;
+
+  // Distance from the player to the boards, in meters
+  static const float RADIUS;
+  // Distance between neighbouring board centers, in meters
+  static const float SPACING;
+
+private:
+  struct WallBoard {
+    Chess::Board  board;
+    mat4          transform;
+    unsigned int  version{ 1 };
+    int           lod{ 0 };
+  };
+
+  std::vector<WallBoard>        boards;
+  // Around each board and its pieces, in the wall's space, for the
+  // MeshBuffer::version in boundsMeshes
+  SphereSet                     boardSpheres;
+  uint32_t                      boundsMeshes{ 0 };
+  std::vector<uint8_t>          visible;
+  oglplus::Buffer               instanceBuffer;
+  oglplus::Buffer               commandBuffer;
+  oglplus::Buffer               boardInstanceBuffer;
+  InstanceData *                instances{ nullptr };
+  DrawElementsIndirectCommand * commands{ nullptr };
+  GLsync                        fences[BUFFER_COPIES];
+  // The board version last written into each region
+  unsigned int                  written[BUFFER_COPIES][MAX_BOARDS];
+  // The Geometry::viewCount and MeshBuffer::version each region's
+  // commands were built for
+  int                           writtenViews[BUFFER_COPIES];
+  uint32_t                      writtenMeshes[BUFFER_COPIES];
+  int                           copy{ 0 };
+  bool                          layoutDirty{ true };
+  bool                          mapped{ false };
+
+public:
+  BoardWall();
+  ~BoardWall();
+
+  // Where the board at index sits on a wall of count boards
+  static mat4 getBoardTransform(int index, int count);
+
+  // Changing the board count re-lays the whole wall
+  void setBoardCount(int count);
+  int getBoardCount() const {
+    return boards.size();
+  }
+  void setBoard(int index, const Chess::Board & board);
+
+  // Call once per frame, before any render calls, with the camera set.
+  // Moves to the next buffer region, picks each board's level of detail
+  // for the eye's pixelScale, see PieceRenderer::getPixelScale, and
+  // writes any boards that changed into it.
+  void update(float pixelScale);
+  // Uses the lighting already set with Uniforms::setLights
+  void render();
+
+private:
+  void map();
+  void layout();
+  void updateBounds(const MeshBuffer & meshes);
+  void writeBoard(int index);
+  GLintptr instanceOffset() const;
+  GLintptr commandOffset() const;
+};
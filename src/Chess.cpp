@@ -32,5 +32,277 @@ namespace Chess {
     return TYPE_NAMES[gameType + 1];
   }
 
+  static const char PROMOTION_CHARS[] = "prnbqk";
+
+  static bool onBoard(int rank, int file) {
+    return rank >= 0 && rank < 8 && file >= 0 && file < 8;
+  }
+
+  static int sign(int i) {
+    return (i > 0) - (i < 0);
+  }
+
+  bool Move::parse(const std::string & coordinates, Move & out) {
+    if (coordinates.size() < 4) {
+      return false;
+    }
+    Move result(
+      coordinates[1] - '1', coordinates[0] - 'a',
+      coordinates[3] - '1', coordinates[2] - 'a');
+    if (!onBoard(result.fromRank, result.fromFile) || !onBoard(result.toRank, result.toFile)) {
+      return false;
+    }
+    if (coordinates.size() > 4) {
+      char c = coordinates[coordinates.size() - 1];
+      const char * found = strchr(PROMOTION_CHARS, tolower(c));
+      if (!c || !found) {
+        return false;
+      }
+      result.promotion = found - PROMOTION_CHARS;
+    }
+    out = result;
+    return true;
+  }
+
+  std::string Move::toString() const {
+    std::string result;
+    result += (char)('a' + fromFile);
+    result += (char)('1' + fromRank);
+    result += (char)('a' + toFile);
+    result += (char)('1' + toRank);
+    if (PieceType::NONE != promotion) {
+      result += PROMOTION_CHARS[promotion];
+    }
+    return result;
+  }
+
+  bool Position::isAttacked(int rank, int file, int bySide) const {
+    // Pawns attack diagonally forward, so look one rank behind the target
+    int pawnRank = rank + (Side::WHITE == bySide ? -1 : 1);
+    for (int df = -1; df <= 1; df += 2) {
+      if (onBoard(pawnRank, file + df) &&
+          board.position[pawnRank][file + df] == makePiece(bySide, PieceType::PAWN)) {
+        return true;
+      }
+    }
+
+    static const int KNIGHT_OFFSETS[8][2] = {
+      { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 },
+      { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 },
+    };
+    for (int i = 0; i < 8; ++i) {
+      int r = rank + KNIGHT_OFFSETS[i][0], f = file + KNIGHT_OFFSETS[i][1];
+      if (onBoard(r, f) && board.position[r][f] == makePiece(bySide, PieceType::KNIGHT)) {
+        return true;
+      }
+    }
+
+    // Kings, then sliding pieces along each of the eight directions
+    for (int dr = -1; dr <= 1; ++dr) {
+      for (int df = -1; df <= 1; ++df) {
+        if (!dr && !df) {
+          continue;
+        }
+        int slider = (dr && df) ? PieceType::BISHOP : PieceType::ROOK;
+        for (int r = rank + dr, f = file + df; onBoard(r, f); r += dr, f += df) {
+          Piece piece = board.position[r][f];
+          if (NP == piece) {
+            continue;
+          }
+          if (pieceSide(piece) == bySide) {
+            int type = pieceType(piece);
+            if (type == slider || type == PieceType::QUEEN) {
+              return true;
+            }
+            if (type == PieceType::KING && r == rank + dr && f == file + df) {
+              return true;
+            }
+          }
+          break;
+        }
+      }
+    }
+    return false;
+  }
+
+  bool Position::isInCheck(int side) const {
+    Piece king = makePiece(side, PieceType::KING);
+    for (int rank = 0; rank < 8; ++rank) {
+      for (int file = 0; file < 8; ++file) {
+        if (board.position[rank][file] == king) {
+          return isAttacked(rank, file, 1 - side);
+        }
+      }
+    }
+    return false;
+  }
+
+  bool Position::isCastling(const Move & move) const {
+    Piece piece = board.position[move.fromRank][move.fromFile];
+    return NP != piece && PieceType::KING == pieceType(piece) &&
+      move.fromRank == move.toRank && 2 == abs(move.toFile - move.fromFile);
+  }
+
+  bool Position::isPathClear(const Move & move) const {
+    int dr = sign(move.toRank - move.fromRank);
+    int df = sign(move.toFile - move.fromFile);
+    int r = move.fromRank + dr, f = move.fromFile + df;
+    while (r != move.toRank || f != move.toFile) {
+      if (NP != board.position[r][f]) {
+        return false;
+      }
+      r += dr;
+      f += df;
+    }
+    return true;
+  }
+
+  bool Position::isPseudoLegal(const Move & move) const {
+    if (!onBoard(move.fromRank, move.fromFile) || !onBoard(move.toRank, move.toFile)) {
+      return false;
+    }
+    Piece piece = board.position[move.fromRank][move.fromFile];
+    if (NP == piece || pieceSide(piece) != nextMove) {
+      return false;
+    }
+    Piece target = board.position[move.toRank][move.toFile];
+    if (NP != target && pieceSide(target) == nextMove) {
+      return false;
+    }
+
+    int side = nextMove;
+    int type = pieceType(piece);
+    int dr = move.toRank - move.fromRank;
+    int df = move.toFile - move.fromFile;
+    int homeRank = Side::WHITE == side ? 0 : 7;
+
+    if (PieceType::NONE != move.promotion) {
+      if (PieceType::PAWN != type || move.toRank != 7 - homeRank) {
+        return false;
+      }
+      if (PieceType::PAWN == move.promotion || PieceType::KING == move.promotion) {
+        return false;
+      }
+    }
+
+    switch (type) {
+    case PieceType::PAWN: {
+      int forward = Side::WHITE == side ? 1 : -1;
+      if (0 == df) {
+        if (NP != target) {
+          return false;
+        }
+        if (dr == forward) {
+          return true;
+        }
+        return dr == 2 * forward && move.fromRank == homeRank + forward &&
+          NP == board.position[move.fromRank + forward][move.fromFile];
+      }
+      if (1 != abs(df) || dr != forward) {
+        return false;
+      }
+      if (NP != target) {
+        return true;
+      }
+      // En passant, only immediately after the opposing double push
+      return pawnPush == move.toFile && move.fromRank == homeRank + 4 * forward;
+    }
+
+    case PieceType::KNIGHT:
+      return (1 == abs(dr) && 2 == abs(df)) || (2 == abs(dr) && 1 == abs(df));
+
+    case PieceType::BISHOP:
+      return abs(dr) == abs(df) && isPathClear(move);
+
+    case PieceType::ROOK:
+      return (!dr != !df) && isPathClear(move);
+
+    case PieceType::QUEEN:
+      return (abs(dr) == abs(df) || !dr || !df) && isPathClear(move);
+
+    case PieceType::KING: {
+      if (abs(dr) <= 1 && abs(df) <= 1) {
+        return true;
+      }
+      if (!isCastling(move) || move.fromRank != homeRank || 4 != move.fromFile) {
+        return false;
+      }
+      int distance = df > 0 ? CastlingDistance::SHORT : CastlingDistance::LONG;
+      int rookFile = df > 0 ? 7 : 0;
+      if (!castling[side][distance] ||
+          board.position[homeRank][rookFile] != makePiece(side, PieceType::ROOK)) {
+        return false;
+      }
+      if (!isPathClear(Move(homeRank, 4, homeRank, rookFile))) {
+        return false;
+      }
+      // The king may not castle out of or through check
+      int opponent = 1 - side;
+      return !isAttacked(homeRank, 4, opponent) &&
+        !isAttacked(homeRank, 4 + sign(df), opponent);
+    }
+    }
+    return false;
+  }
+
+  bool Position::isLegal(const Move & move) const {
+    if (!isPseudoLegal(move)) {
+      return false;
+    }
+    Position after(*this);
+    after.apply(move);
+    return !after.isInCheck(nextMove);
+  }
+
+  void Position::apply(const Move & move) {
+    Piece piece = board.position[move.fromRank][move.fromFile];
+    int side = pieceSide(piece);
+    int type = pieceType(piece);
+    int homeRank = Side::WHITE == side ? 0 : 7;
+
+    if (PieceType::PAWN == type && move.fromFile != move.toFile &&
+        NP == board.position[move.toRank][move.toFile]) {
+      // En passant removes the pawn that was passed
+      board.position[move.fromRank][move.toFile] = NP;
+    }
+
+    if (isCastling(move)) {
+      int rookFrom = move.toFile > move.fromFile ? 7 : 0;
+      int rookTo = move.toFile > move.fromFile ? 5 : 3;
+      board.position[homeRank][rookTo] = board.position[homeRank][rookFrom];
+      board.position[homeRank][rookFrom] = NP;
+    }
+
+    board.position[move.toRank][move.toFile] = piece;
+    board.position[move.fromRank][move.fromFile] = NP;
+    if (PieceType::PAWN == type && (0 == move.toRank || 7 == move.toRank)) {
+      int promotion = PieceType::NONE == move.promotion ? PieceType::QUEEN : move.promotion;
+      board.position[move.toRank][move.toFile] = makePiece(side, promotion);
+    }
+
+    if (PieceType::KING == type) {
+      castling[side][CastlingDistance::SHORT] = false;
+      castling[side][CastlingDistance::LONG] = false;
+    }
+    // Moving a rook from, or capturing one on, its corner loses that right
+    forEachSide([&](int s){
+      int rank = Side::WHITE == s ? 0 : 7;
+      if ((move.fromRank == rank || move.toRank == rank)) {
+        if (7 == move.fromFile || 7 == move.toFile) {
+          if (board.position[rank][7] != makePiece(s, PieceType::ROOK)) {
+            castling[s][CastlingDistance::SHORT] = false;
+          }
+        }
+        if (0 == move.fromFile || 0 == move.toFile) {
+          if (board.position[rank][0] != makePiece(s, PieceType::ROOK)) {
+            castling[s][CastlingDistance::LONG] = false;
+          }
+        }
+      }
+    });
+
+    pawnPush = (PieceType::PAWN == type && 2 == abs(move.toRank - move.fromRank)) ? move.toFile : -1;
+    nextMove = 1 - side;
+  }
 
 }
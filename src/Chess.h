@@ -30,6 +30,19 @@ namespace Chess {
     };
   }
 
+  namespace PieceType {
+    enum {
+      NONE = -1,
+      PAWN,
+      ROOK,
+      KNIGHT,
+      BISHOP,
+      QUEEN,
+      KING,
+      COUNT,
+    };
+  }
+
   enum Piece {
       NP = 0x00,
       WP = 0x01,
@@ -47,6 +60,20 @@ namespace Chess {
       BK,
   };
 
+  inline int pieceType(Piece piece) {
+    return (piece - 1) & 0x0F;
+  }
+
+  inline int pieceSide(Piece piece) {
+    return (piece & 0x10) ? Side::BLACK : Side::WHITE;
+  }
+
+  inline Piece makePiece(int side, int type) {
+    return static_cast<Piece>((Side::WHITE == side ? WP : BP) + type);
+  }
+
+  // Squares are indexed as position[rank][file], so position[0][0] is a1
+  // and white starts on the low ranks
   struct Board {
     Piece position[8][8];
     static Piece STANDARD_BOARD[64];
@@ -56,6 +83,49 @@ namespace Chess {
     }
   };
 
+  struct Move {
+    int fromRank{ 0 };
+    int fromFile{ 0 };
+    int toRank{ 0 };
+    int toFile{ 0 };
+    int promotion{ PieceType::NONE };
+
+    Move() {
+    }
+
+    Move(int fromRank, int fromFile, int toRank, int toFile, int promotion = PieceType::NONE)
+      : fromRank(fromRank), fromFile(fromFile), toRank(toRank), toFile(toFile), promotion(promotion) {
+    }
+
+    // Parses coordinate notation such as "e2e4" or "e7e8q"
+    static bool parse(const std::string & coordinates, Move & out);
+    std::string toString() const;
+  };
+
+  // Everything needed to decide if a move is legal without asking the server
+  struct Position {
+    Board   board;
+    int     nextMove{ Side::WHITE };
+    // The file of a double pawn push on the previous move, or -1
+    int     pawnPush{ -1 };
+    bool    castling[2][2];
+
+    Position() {
+      memset(castling, 1, sizeof(castling));
+    }
+
+    bool isAttacked(int rank, int file, int bySide) const;
+    bool isInCheck(int side) const;
+    bool isCastling(const Move & move) const;
+    bool isLegal(const Move & move) const;
+    // Applies a move that has already been checked with isLegal
+    void apply(const Move & move);
+
+  private:
+    bool isPseudoLegal(const Move & move) const;
+    bool isPathClear(const Move & move) const;
+  };
+
   template <typename Function>
   void forEachSquare(Function f) {
     for (int row = 0; row < 8; ++row) {
@@ -24,6 +24,7 @@
 #include <Windows.h>
 #else
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 #endif
 
@@ -48,6 +49,30 @@ long Platform::elapsedMillis() {
 #endif
 }
 
+int64_t Platform::elapsedNanos() {
+#ifdef WIN32
+  static LARGE_INTEGER frequency;
+  static LARGE_INTEGER start;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&start);
+  }
+  LARGE_INTEGER now;
+  QueryPerformanceCounter(&now);
+  int64_t ticks = now.QuadPart - start.QuadPart;
+  return (ticks / frequency.QuadPart) * 1000000000LL +
+    ((ticks % frequency.QuadPart) * 1000000000LL) / frequency.QuadPart;
+#else
+  timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  int64_t nanos = (int64_t)time.tv_sec * 1000000000LL + time.tv_nsec;
+  static int64_t start = nanos;
+  return nanos - start;
+#endif
+}
+
 #ifndef WIN32
 #define MAX_PATH 4096
 #endif
@@ -131,6 +156,14 @@ time_t Platform::getResourceModified(Resource resource) {
   return Resources::getResourceModified(resource);
 }
 
+std::string Platform::getResourceFile(Resource resource) {
+  char path[MAX_PATH + 1];
+  if (!Resources::getResourceFile(resource, path, MAX_PATH)) {
+    return std::string();
+  }
+  return path;
+}
+
 std::vector<uint8_t> Platform::getResourceVector(Resource resource) {
   size_t size = Resources::getResourceSize(resource);
   std::vector<uint8_t> result;
@@ -139,4 +172,21 @@ std::vector<uint8_t> Platform::getResourceVector(Resource resource) {
   return result;
 }
 
+std::string Platform::getCachePath(const std::string & name) {
+  std::string result;
+  char * path = SDL_GetPrefPath("VirtualChess", name.c_str());
+  if (path) {
+    result = path;
+    SDL_free(path);
+  }
+  return result;
+}
 
+uint64_t Platform::hash(const void * data, size_t size, uint64_t seed) {
+  const uint8_t * bytes = (const uint8_t *)data;
+  uint64_t result = seed;
+  for (size_t i = 0; i < size; ++i) {
+    result = (result ^ bytes[i]) * 1099511628211ULL;
+  }
+  return result;
+}
@@ -31,13 +31,16 @@
 #define __STDC_FORMAT_MACROS 1
 
 #include <cassert>
+#include <cfloat>
 #include <cmath>
 #include <cstdint>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <deque>
 #include <iostream>
 #include <list>
@@ -48,6 +51,11 @@
 #include <sstream>
 #include <unordered_map>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define HAVE_SSE 1
+#include <xmmintrin.h>
+#endif
+
 #include <boost/bind.hpp>
 #include <boost/asio.hpp>
 #include <boost/thread.hpp>
@@ -68,6 +76,7 @@ void withScopedLock(boost::mutex & mutex, Function f) {
 #include <glm/gtc/noise.hpp>
 #include <glm/gtc/epsilon.hpp>
 #include <glm/gtx/norm.hpp>
+#include <glm/gtc/packing.hpp>
 
 using glm::ivec3;
 using glm::ivec2;
@@ -108,14 +117,23 @@ class Platform {
 public:
     static void sleepMillis(int millis);
     static long elapsedMillis();
+    // Monotonic, unaffected by changes to the wall clock
+    static int64_t elapsedNanos();
     static float elapsedSeconds();
     static void fail(const char * file, int line, const char * message, ...);
     static void say(std::ostream & out, const char * message, ...);
     static std::string format(const char * formatString, ...);
     static std::string getResourcePath(Resource resource);
     static time_t getResourceModified(Resource resource);
+    // Empty if the resource is embedded rather than read from a file
+    static std::string getResourceFile(Resource resource);
     static std::string getResourceString(Resource resource);
     static std::vector<uint8_t> getResourceVector(Resource resource);
+    // A writable per user directory for cached data, created if needed,
+    // with a trailing separator.  Empty if there's nowhere to write.
+    static std::string getCachePath(const std::string & name);
+    // 64 bit FNV-1a, chainable by passing the previous result as the seed
+    static uint64_t hash(const void * data, size_t size, uint64_t seed = 14695981039346656037ULL);
 };
 
 #ifndef PI
@@ -175,18 +193,33 @@ inline float aspect(T const & size) {
 #include "Chess.h"
 #include "Colors.h"
 #include "Files.h"
+#include "ResourceWatcher.h"
+#include "Profiler.h"
 #include "Interaction.h"
 #include "Stacks.h"
+#include "TripleBuffer.h"
 #include "Strings.h"
 #include "SocketClient.h"
 #include "GlDebug.h"
 
 // Second order dependencies
+#include "Registry.h"
 #include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "Culling.h"
 
 // Thord order
 #include "GlUtils.h"
+#include "MeshCache.h"
+#include "MeshBuffer.h"
+#include "Uniforms.h"
+#include "GpuTimer.h"
 #include "RenderUtils.h"
+#include "SkyboxCache.h"
+#include "Multires.h"
+#include "PieceRenderer.h"
+#include "BoardWall.h"
+#include "AssetLoader.h"
 #include "SdlWrapperApp.h"
 #include "Gui.h"
 
@@ -0,0 +1,128 @@
+#include "Common.h"
+
+bool Culling::enabled = true;
+
+Bounds Bounds::of(const Mesh & mesh) {
+  Bounds result;
+  for (size_t i = 0; i < mesh.positions.size(); ++i) {
+    const vec4 & position = mesh.positions[i];
+    result.add(vec3(position.x, position.y, position.z));
+  }
+  return result;
+}
+
+void SphereSet::add(const Bounds & bounds, const mat4 & transform) {
+  float r = FLT_MAX;
+  vec4 center(0, 0, 0, 1);
+  if (!bounds.empty()) {
+    center = transform * vec4(bounds.center(), 1);
+    // Scaled by the largest axis of the transform
+    float scale = std::max(glm::length(vec3(transform[0])),
+      std::max(glm::length(vec3(transform[1])), glm::length(vec3(transform[2]))));
+    r = bounds.radius() * scale;
+  }
+  x.push_back(center.x);
+  y.push_back(center.y);
+  z.push_back(center.z);
+  radius.push_back(r);
+}
+
+// Six planes per view, as a, b, c, d with a * x + b * y + c * z + d
+// negative outside
+static vec4 planes[Culling::MAX_VIEWS][6];
+static mat4 clips[Culling::MAX_VIEWS];
+static int viewCount = 0;
+
+void Culling::setViews(const mat4 * newClips, int count) {
+  viewCount = std::min(count, (int)MAX_VIEWS);
+  for (int i = 0; i < viewCount; ++i) {
+    clips[i] = newClips[i];
+  }
+}
+
+// Gribb and Hartmann's extraction from the rows of the clip transform,
+// normalized so the distances compare with radii
+static void extractPlanes(const mat4 & modelview) {
+  for (int v = 0; v < viewCount; ++v) {
+    mat4 m = clips[v] * modelview;
+    vec4 rows[4];
+    for (int i = 0; i < 4; ++i) {
+      rows[i] = vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+    }
+    for (int i = 0; i < 3; ++i) {
+      planes[v][i * 2] = rows[3] + rows[i];
+      planes[v][i * 2 + 1] = rows[3] - rows[i];
+    }
+    for (int i = 0; i < 6; ++i) {
+      planes[v][i] /= glm::length(vec3(planes[v][i]));
+    }
+  }
+}
+
+static bool testSphere(float x, float y, float z, float r) {
+  for (int v = 0; v < viewCount; ++v) {
+    bool inside = true;
+    for (int i = 0; i < 6 && inside; ++i) {
+      const vec4 & p = planes[v][i];
+      inside = p.x * x + p.y * y + p.z * z + p.w > -r;
+    }
+    if (inside) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int Culling::cull(const SphereSet & spheres, const mat4 & modelview, std::vector<uint8_t> & visible) {
+  size_t count = spheres.size();
+  visible.resize(count);
+  if (!enabled || !viewCount) {
+    std::fill(visible.begin(), visible.end(), 1);
+    return count;
+  }
+
+  extractPlanes(modelview);
+  size_t i = 0;
+#ifdef HAVE_SSE
+  for (; i + 4 <= count; i += 4) {
+    __m128 x = _mm_loadu_ps(&spheres.x[i]);
+    __m128 y = _mm_loadu_ps(&spheres.y[i]);
+    __m128 z = _mm_loadu_ps(&spheres.z[i]);
+    __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(&spheres.radius[i]));
+    __m128 any = _mm_setzero_ps();
+    for (int v = 0; v < viewCount; ++v) {
+      __m128 inside = _mm_cmpeq_ps(x, x);
+      for (int p = 0; p < 6; ++p) {
+        const vec4 & plane = planes[v][p];
+        __m128 distance = _mm_add_ps(
+          _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(plane.x)), _mm_mul_ps(y, _mm_set1_ps(plane.y))),
+          _mm_add_ps(_mm_mul_ps(z, _mm_set1_ps(plane.z)), _mm_set1_ps(plane.w)));
+        inside = _mm_and_ps(inside, _mm_cmpgt_ps(distance, negativeRadius));
+      }
+      any = _mm_or_ps(any, inside);
+    }
+    int mask = _mm_movemask_ps(any);
+    for (int j = 0; j < 4; ++j) {
+      visible[i + j] = (mask >> j) & 1;
+    }
+  }
+#endif
+  for (; i < count; ++i) {
+    visible[i] = testSphere(spheres.x[i], spheres.y[i], spheres.z[i], spheres.radius[i]);
+  }
+
+  int result = 0;
+  for (i = 0; i < count; ++i) {
+    result += visible[i];
+  }
+  return result;
+}
+
+bool Culling::isVisible(const Bounds & bounds, const mat4 & modelview) {
+  if (!enabled || !viewCount || bounds.empty()) {
+    return true;
+  }
+  extractPlanes(modelview);
+  vec3 center = bounds.center();
+  return testSphere(center.x, center.y, center.z, bounds.radius());
+}
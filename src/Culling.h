@@ -0,0 +1,73 @@
+#pragma once
+
+// An axis aligned box, in the space of the vertices it was built from.
+// Empty until a point is added, and empty bounds are never culled.
+struct Bounds {
+  vec3 min{ FLT_MAX };
+  vec3 max{ -FLT_MAX };
+
+  bool empty() const {
+    return min.x > max.x;
+  }
+
+  void add(const vec3 & point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  vec3 center() const {
+    return (min + max) / 2.0f;
+  }
+
+  // The bounding sphere's radius
+  float radius() const {
+    return glm::length(max - min) / 2.0f;
+  }
+
+  static Bounds of(const Mesh & mesh);
+};
+
+// Bounding spheres as separate arrays of each component, so the plane
+// tests can run four spheres at a time
+struct SphereSet {
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  std::vector<float> radius;
+
+  size_t size() const {
+    return x.size();
+  }
+
+  void clear() {
+    x.clear();
+    y.clear();
+    z.clear();
+    radius.clear();
+  }
+
+  // The sphere around the bounds, after the transform
+  void add(const Bounds & bounds, const mat4 & transform = mat4());
+};
+
+// Frustum culling against the views being drawn.  Before drawing, the app
+// sets the clip transform of each view relative to the modelview the
+// scene starts from.  With single pass stereo that's both eyes, and
+// anything either eye can see is visible.  Until views are set,
+// everything is.
+class Culling {
+  Culling() {}
+
+public:
+  static const int MAX_VIEWS = 2;
+  // Switched off, everything is visible, for comparing costs
+  static bool enabled;
+
+  static void setViews(const mat4 * clips, int count);
+
+  // Sets visible[i] to 1 for every sphere, given in the space of
+  // modelview, that one of the views can see and 0 otherwise.  Returns
+  // the number visible.
+  static int cull(const SphereSet & spheres, const mat4 & modelview, std::vector<uint8_t> & visible);
+  static bool isVisible(const Bounds & bounds, const mat4 & modelview);
+};
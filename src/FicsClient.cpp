@@ -2,6 +2,7 @@
 #include "FicsClient.h"
 
 #include <exception>
+#include <boost/atomic.hpp>
 
 using namespace boost;
 using namespace std;
@@ -307,25 +308,27 @@ namespace Fics {
     return result;
   }
 
+  // Style12 uses upper case for white and lower case for black
   Piece pieceFromChar(char c) {
     switch (c) {
-    case 'p': return WP;
-    case 'r': return WR;
-    case 'n': return WN;
-    case 'b': return WB;
-    case 'q': return WQ;
-    case 'k': return WK;
-    case 'P': return BP;
-    case 'R': return BR;
-    case 'N': return BN;
-    case 'B': return BB;
-    case 'Q': return BQ;
-    case 'K': return BK;
+    case 'P': return WP;
+    case 'R': return WR;
+    case 'N': return WN;
+    case 'B': return WB;
+    case 'Q': return WQ;
+    case 'K': return WK;
+    case 'p': return BP;
+    case 'r': return BR;
+    case 'n': return BN;
+    case 'b': return BB;
+    case 'q': return BQ;
+    case 'k': return BK;
     }
     return NP;
   }
 
   void GameState::parseStyle12(const string & gameState) {
+    Profiler::Zone zone("parseStyle12");
     enum Offsets {
       BOARD = 5,
       RANK_SIZE = 9,
@@ -333,10 +336,11 @@ namespace Fics {
       PAWN_PUSH = NEXT_MOVE + 2,
     };
     assert(0 == gameState.find("<12> "));
+    // The ranks are listed from the 8th down to the 1st
     for (int rank = 0; rank < 8; ++rank) {
       const char * rankData = gameState.data() + rank * RANK_SIZE + BOARD;
       for (int col = 0; col < 8; ++col) {
-        board.position[rank][col] = pieceFromChar(rankData[col]);
+        board.position[7 - rank][col] = pieceFromChar(rankData[col]);
       }
     }
     char c = gameState.at(NEXT_MOVE);
@@ -394,6 +398,13 @@ namespace Fics {
     buf >> lastMovePretty;
     //* flip field for board orientation : 1 = Black at bottom, 0
     buf >> c;
+    //* 1 if the clock is ticking (absent from older servers)
+    int ticking;
+    if (buf >> ticking) {
+      clockTicking = ticking ? true : false;
+      //* lag in milliseconds
+      buf >> lastMoveLag;
+    }
   }
 
   struct Command {
@@ -404,11 +415,42 @@ namespace Fics {
     boost::mutex mutex;
   };
 
+  // FICS wants moves in coordinate notation, with castling spelled out
+  string ficsMoveString(const Position & position, const Move & move) {
+    if (position.isCastling(move)) {
+      return move.toFile > move.fromFile ? "o-o" : "o-o-o";
+    }
+    string result = move.toString();
+    if (PieceType::NONE != move.promotion) {
+      result.insert(4, "=");
+    }
+    return result;
+  }
+
   class ClientImpl : public SocketClient, public Client {
     boost::asio::io_service io_service;
     string readBuffer;
     string username, password;
-    int commandId{10};
+    boost::atomic<int> commandId{10};
+
+    // Games we are a player in, with any premoves waiting on the opponent.
+    // Written on the I/O thread and read by makeMove, so guarded by gamesMutex
+    struct PlayedGame {
+      GameState     state;
+      deque<Move>   premoves;
+    };
+    typedef map<int, PlayedGame> PlayedGameMap;
+    boost::mutex gamesMutex;
+    PlayedGameMap playedGames;
+
+    // Send times of outstanding commands, keyed by command id, used to
+    // estimate the lag from the block mode replies
+    typedef map<int, int64_t> SendTimeMap;
+    boost::mutex sendTimesMutex;
+    SendTimeMap sendTimes;
+    boost::atomic<int64_t> lagNanos{ 0 };
+    // When the data currently being parsed arrived
+    int64_t readNanos{ 0 };
 
     enum State {
       CONNECT, WAIT_LOGIN, WAIT_PASSWORD, LOGGED_IN, INTERFACE_SETUP, IDLE, FAIL
@@ -432,12 +474,88 @@ namespace Fics {
       ::SocketClient::connect(endpoint_iterator);
     }
 
+    int nextCommandId() {
+      int id = commandId++;
+      withScopedLock(sendTimesMutex, [&](const boost::mutex::scoped_lock &){
+        sendTimes[id] = Platform::elapsedNanos();
+      });
+      return id;
+    }
+
     void command(const string & commandString) {
-      write(Platform::format("%d %s\n", commandId++, commandString.c_str()));
+      write(Platform::format("%d %s\n", nextCommandId(), commandString.c_str()));
+    }
+
+    void onCommandReply(int id) {
+      int64_t sent = -1;
+      withScopedLock(sendTimesMutex, [&](const boost::mutex::scoped_lock &){
+        SendTimeMap::iterator itr = sendTimes.find(id);
+        if (sendTimes.end() != itr) {
+          sent = itr->second;
+          sendTimes.erase(itr);
+        }
+      });
+      if (sent < 0) {
+        return;
+      }
+      static const int64_t MAX_SAMPLE = 2000000000LL;
+      int64_t oneWay = (readNanos - sent) / 2;
+      // Slow commands like 'games' measure the server more than the
+      // network, so ignore outliers and smooth the rest
+      if (oneWay > MAX_SAMPLE) {
+        return;
+      }
+      int64_t lag = lagNanos;
+      lagNanos = lag ? lag + (oneWay - lag) / 8 : oneWay;
+    }
+
+    // Must be called with gamesMutex held
+    void sendMove(PlayedGame & game, const Move & move) {
+      writeNow(Platform::format("%d %s\n", nextCommandId(),
+        ficsMoveString(game.state, move).c_str()));
+      // Assume the server will accept it, so that further moves are
+      // checked against the position it will produce
+      game.state.apply(move);
+      game.state.relation = PLAYING_OPPONENT_MOVE;
+    }
+
+    // Called on the I/O thread for every Style12 update, before the event
+    // handler sees it, so a premove costs no more than the parse
+    void onGameState(GameState & state) {
+      state.receivedNanos = readNanos;
+      bool playing = PLAYING_MY_MOVE == state.relation ||
+        PLAYING_OPPONENT_MOVE == state.relation;
+      withScopedLock(gamesMutex, [&](const boost::mutex::scoped_lock &){
+        if (!playing) {
+          playedGames.erase(state.id);
+          return;
+        }
+        PlayedGame & game = playedGames[state.id];
+        game.state = state;
+        if (PLAYING_MY_MOVE != state.relation || game.premoves.empty()) {
+          return;
+        }
+        Move premove = game.premoves.front();
+        game.premoves.pop_front();
+        if (game.state.isLegal(premove)) {
+          sendMove(game, premove);
+        } else {
+          SAY("Discarding illegal premove %s", premove.toString().c_str());
+          game.premoves.clear();
+        }
+      });
+
+      if (callback) {
+        Event ev;
+        ev.gameState.type = EventType::GAME_STATE;
+        ev.gameState.state = &state;
+        callback(ev);
+      }
     }
 
   protected:
     void onRead(ReadBuffer & buffer) {
+      readNanos = Platform::elapsedNanos();
       readBuffer.append(buffer.begin(), buffer.end());
       buffer.clear();
       switch (state) {
@@ -492,6 +610,7 @@ namespace Fics {
     }
 
     void parseCommands() {
+      Profiler::Zone zone("parseCommands");
       int startCommand, endCommand;
       while (string::npos != (startCommand = readBuffer.find(BlockDelimiter::BLOCK_START))) {
         endCommand = readBuffer.find(BlockDelimiter::BLOCK_END, startCommand);
@@ -511,6 +630,7 @@ namespace Fics {
       int codeSep = command.find(BlockDelimiter::BLOCK_SEPARATOR, idSep);
       int commandCode = atoi(command.substr(idSep, codeSep++ - idSep).c_str());
       string commandResult = command.substr(codeSep);
+      onCommandReply(commandId);
       switch (commandCode) {
       case BlockCode::BLK_ISET:
         if (INTERFACE_SETUP == state) {
@@ -540,11 +660,8 @@ namespace Fics {
           for (int i = 0; i < lines.size(); ++i) {
             const string & str = lines[i];
             if (0 == str.find("<12>")) {
-              GameStatePtr ptr(new GameState(str));
-              Event ev;
-              ev.gameState.type = EventType::GAME_STATE;
-              ev.gameState.state = ptr.get();
-              callback(ev);
+              GameState state(str);
+              onGameState(state);
             }
           }
         } return;
@@ -567,10 +684,8 @@ namespace Fics {
         std::string line = rawline.substr(start);
         Event ev;
         if (0 == line.find("<12> ")) {
-          GameStatePtr ptr(new GameState(line));
-          ev.gameState.type = EventType::GAME_STATE;
-          ev.gameState.state = ptr.get();
-          callback(ev);
+          GameState state(line);
+          onGameState(state);
         }
         else {
           ev.chat.type = EventType::CHAT;
@@ -598,6 +713,50 @@ namespace Fics {
     virtual void unobserveGame(int id) {
       command(Platform::format("unobserve %d", id));
     }
+
+    virtual int makeMove(int gameId, const Move & move) {
+      boost::mutex::scoped_lock lock(gamesMutex);
+      PlayedGameMap::iterator itr = playedGames.find(gameId);
+      if (playedGames.end() == itr) {
+        return MoveResult::NOT_PLAYING;
+      }
+      PlayedGame & game = itr->second;
+      if (PLAYING_MY_MOVE == game.state.relation && game.premoves.empty()) {
+        if (!game.state.isLegal(move)) {
+          return MoveResult::ILLEGAL;
+        }
+        sendMove(game, move);
+        return MoveResult::SENT;
+      }
+
+      // The opponent's reply is unknown, so a premove can only be checked
+      // for moving one of our own pieces.  The rest is checked on arrival.
+      if (move.fromRank < 0 || move.fromRank > 7 || move.fromFile < 0 || move.fromFile > 7 ||
+          move.toRank < 0 || move.toRank > 7 || move.toFile < 0 || move.toFile > 7) {
+        return MoveResult::ILLEGAL;
+      }
+      Piece piece = game.state.board.position[move.fromRank][move.fromFile];
+      int mySide = PLAYING_MY_MOVE == game.state.relation ?
+        game.state.nextMove : 1 - game.state.nextMove;
+      if (game.premoves.empty() && (NP == piece || pieceSide(piece) != mySide)) {
+        return MoveResult::ILLEGAL;
+      }
+      game.premoves.push_back(move);
+      return MoveResult::QUEUED;
+    }
+
+    virtual int estimatedLagMillis() {
+      return (int)(lagNanos / 1000000);
+    }
+
+    virtual void clearPremoves(int gameId) {
+      withScopedLock(gamesMutex, [&](const boost::mutex::scoped_lock &){
+        PlayedGameMap::iterator itr = playedGames.find(gameId);
+        if (playedGames.end() != itr) {
+          itr->second.premoves.clear();
+        }
+      });
+    }
   };
 
   ClientPtr Client::create() {
@@ -36,11 +36,7 @@ namespace Fics {
   typedef std::shared_ptr<GameList> GameListPtr;
 
   // http://www.freechess.org/Help/HelpFiles/style12.html
-  struct GameState : public GameBase {
-    Board   board;
-    int     nextMove;
-    int     pawnPush;
-    bool    castling[2][2];
+  struct GameState : public GameBase, public Position {
     int     reversibleMoves;
     int     relation;
     int     initialTime;
@@ -51,6 +47,11 @@ namespace Fics {
     std::string  lastMoveVerbose;
     std::string  lastMoveTime;
     std::string  lastMovePretty;
+    bool    clockTicking{ true };
+    // The server's measure of the lag on the last move, in milliseconds
+    int     lastMoveLag{ 0 };
+    // Platform::elapsedNanos() when the update arrived on the socket
+    int64_t receivedNanos{ 0 };
 
     GameState() {
 
@@ -67,6 +68,17 @@ namespace Fics {
   class Client;
   typedef std::shared_ptr<Client> ClientPtr;
 
+  namespace MoveResult {
+    enum {
+      // Legal and written to the server
+      SENT,
+      // Held as a premove until the opponent's move arrives
+      QUEUED,
+      ILLEGAL,
+      NOT_PLAYING,
+    };
+  }
+
   namespace EventType {
     enum {
       NETWORK,
@@ -123,6 +135,13 @@ namespace Fics {
     virtual void listGames() = 0;
     virtual void observeGame(int id) = 0;
     virtual void unobserveGame(int id) = 0;
+    // Validates the move against the last known position before sending it.
+    // If it's the opponent's turn the move is queued as a premove and sent
+    // from the network thread as soon as their move arrives.
+    virtual int makeMove(int gameId, const Move & move) = 0;
+    virtual void clearPremoves(int gameId) = 0;
+    // One way network delay, estimated from command round trips
+    virtual int estimatedLagMillis() = 0;
     virtual void setEventHandler(boost::function<void(const Event&)> callback) {
       this->callback = callback;
     }
@@ -130,3 +149,5 @@ namespace Fics {
 
 
 }
+
+#include "GameClock.h"
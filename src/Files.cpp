@@ -22,6 +22,12 @@
 #include <sstream>
 #include <cassert>
 #include <stdexcept>
+#ifndef WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 #undef HAVE_BOOST
 #ifdef HAVE_BOOST
@@ -54,6 +60,29 @@ time_t Files::modified(const string & filename) {
 }
 
 
+bool Files::replace(const string & filename, const void * data, size_t size) {
+  // The temporary name is unique to the thread
+  stringstream tempName;
+  tempName << filename << "." << boost::this_thread::get_id() << ".tmp";
+  string temp = tempName.str();
+  {
+    ofstream out(temp.c_str(), ios::binary | ios::trunc);
+    if (!out.write((const char *)data, size)) {
+      return false;
+    }
+  }
+  std::remove(filename.c_str());
+  return 0 == std::rename(temp.c_str(), filename.c_str());
+}
+
+string Files::flatten(const string & path) {
+  string result = path;
+  std::replace(result.begin(), result.end(), '/', '_');
+  std::replace(result.begin(), result.end(), '\\', '_');
+  std::replace(result.begin(), result.end(), ':', '_');
+  return result;
+}
+
 bool Files::exists(const string & filename) {
 #ifdef HAVE_BOOST
   return boost::filesystem::exists(filename);
@@ -62,3 +91,61 @@ bool Files::exists(const string & filename) {
   return false;
 #endif
 }
+
+#ifdef WIN32
+MappedFile::MappedFile(const string & filename) {
+  file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+    nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (INVALID_HANDLE_VALUE == file) {
+    file = nullptr;
+    return;
+  }
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(file, &fileSize) || 0 == fileSize.QuadPart) {
+    return;
+  }
+  mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (!mapping) {
+    return;
+  }
+  bytes = (const unsigned char *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (bytes) {
+    length = (size_t)fileSize.QuadPart;
+  }
+}
+
+MappedFile::~MappedFile() {
+  if (bytes) {
+    UnmapViewOfFile(bytes);
+  }
+  if (mapping) {
+    CloseHandle(mapping);
+  }
+  if (file) {
+    CloseHandle(file);
+  }
+}
+#else
+MappedFile::MappedFile(const string & filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (0 == fstat(fd, &st) && st.st_size > 0) {
+    void * result = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED != result) {
+      bytes = (const unsigned char *)result;
+      length = st.st_size;
+    }
+  }
+  // The mapping keeps its own reference to the file
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (bytes) {
+    munmap((void *)bytes, length);
+  }
+}
+#endif
@@ -26,5 +26,38 @@ public:
   static std::string read(const std::string & filename);
   static time_t modified(const std::string & filename);
   static bool exists(const std::string & filename);
+  // Writes the file aside and renames it into place, so readers never see
+  // a partial file.  Safe to call from several threads for the same file.
+  static bool replace(const std::string & filename, const void * data, size_t size);
+  // Replaces path separators, so a resource path can name a single file
+  static std::string flatten(const std::string & path);
+};
+
+// A read only view of a whole file, mapped into memory.  isValid() is
+// false if the file couldn't be opened or mapped.
+class MappedFile {
+  const unsigned char * bytes{ nullptr };
+  size_t length{ 0 };
+#ifdef WIN32
+  void * file{ nullptr };
+  void * mapping{ nullptr };
+#endif
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile & operator=(const MappedFile &) = delete;
+
+public:
+  explicit MappedFile(const std::string & filename);
+  ~MappedFile();
+
+  bool isValid() const {
+    return nullptr != bytes;
+  }
+  const unsigned char * data() const {
+    return bytes;
+  }
+  size_t size() const {
+    return length;
+  }
 };
 
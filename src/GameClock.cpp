@@ -0,0 +1,65 @@
+#include "Common.h"
+#include "FicsClient.h"
+
+namespace Fics {
+
+  const int64_t GameClock::CORRECTION_NANOS = 250000000LL;
+
+  GameClock::GameClock() {
+    reset();
+  }
+
+  void GameClock::reset() {
+    gameId = -1;
+    running = -1;
+    receivedNanos = 0;
+    forEachSide([&](int side){
+      remaining[side] = 0;
+      correction[side] = 0;
+    });
+  }
+
+  void GameClock::update(const GameState & state, int lagMillis) {
+    int newRunning = state.clockTicking ? state.nextMove : -1;
+    // Smooth the update only if the same clock has been running since the
+    // last one, otherwise a move was made and the new time is exact
+    bool smooth = state.id == gameId && newRunning == running;
+
+    forEachSide([&](int side){
+      int64_t shown = remainingMillis(side, state.receivedNanos) * 1000000LL;
+      int64_t value = (int64_t)state.remainingTime[side] * 1000000LL;
+      // The server sent this one lag ago, and the clock kept running
+      if (side == newRunning) {
+        value -= (int64_t)lagMillis * 1000000LL;
+      }
+      remaining[side] = value;
+      correction[side] = smooth ? shown - value : 0;
+    });
+    gameId = state.id;
+    running = newRunning;
+    receivedNanos = state.receivedNanos;
+  }
+
+  int GameClock::remainingMillis(int side, int64_t nowNanos) const {
+    if (-1 == gameId) {
+      return 0;
+    }
+    int64_t elapsed = std::max<int64_t>(0, nowNanos - receivedNanos);
+    int64_t result = remaining[side];
+    if (side == running) {
+      result -= elapsed;
+    }
+    if (elapsed < CORRECTION_NANOS) {
+      // Linear rather than exponential, so it's finished after CORRECTION_NANOS.
+      // In double, since a large correction times the fade overflows int64.
+      result += (int64_t)((double)correction[side] *
+        (CORRECTION_NANOS - elapsed) / CORRECTION_NANOS);
+    }
+    // A negative clock means a flag, but the display should stop at zero
+    return (int)(std::max<int64_t>(0, result) / 1000000LL);
+  }
+
+  int GameClock::remainingMillis(int side) const {
+    return remainingMillis(side, Platform::elapsedNanos());
+  }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+namespace Fics {
+
+  // Counts both players' clocks down between Style12 updates, so the time
+  // can be drawn every frame without asking the server.  Times are in
+  // milliseconds, which is what the server sends once 'iset ms 1' is on.
+  class GameClock {
+    int       gameId{ -1 };
+    // The side whose clock is running, or -1 if neither is
+    int       running{ -1 };
+    // Lag corrected remaining time as of receivedNanos
+    int64_t   remaining[2];
+    int64_t   receivedNanos{ 0 };
+    // The gap between what we were showing and the new update.  It decays
+    // to zero so corrections don't make the display jump.
+    int64_t   correction[2];
+
+  public:
+    // How long a correction takes to fade out
+    static const int64_t CORRECTION_NANOS;
+
+    GameClock();
+
+    void update(const GameState & state, int lagMillis);
+    void reset();
+
+    // False until the first update, or after a reset
+    bool isActive() const {
+      return -1 != gameId;
+    }
+
+    bool isRunning(int side) const {
+      return side == running;
+    }
+
+    // Remaining time at a Platform::elapsedNanos() timestamp
+    int remainingMillis(int side, int64_t nowNanos) const;
+    int remainingMillis(int side) const;
+  };
+}
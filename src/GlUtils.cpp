@@ -116,6 +116,8 @@ void compileShaders(const Resource * shaders) {
 
 
 Resource SHADER_INCLUDES[] = {
+  SHADERS_UNIFORMS_GLSL,
+  SHADERS_STEREO_GLSL,
   SHADERS_NOISE_CELLULAR2_GLSL,
   SHADERS_NOISE_CELLULAR2X2_GLSL,
   SHADERS_NOISE_CELLULAR2X2X2_GLSL,
@@ -133,22 +135,153 @@ Resource SHADER_INCLUDES[] = {
 typedef std::pair<Resource, Resource> ProgramId;
 typedef std::shared_ptr<Program> ProgramPtr;
 
+// Linked programs are saved with glGetProgramBinary, one file per shader
+// pair.  The key hashes every source that can go into the program, and
+// the driver that built it, so edits and driver updates both miss.
+struct ProgramBinaryHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t length;
+};
+
+static const uint32_t PROGRAM_BINARY_MAGIC = 0x50484356; // "VCHP"
+static const uint32_t PROGRAM_BINARY_VERSION = 1;
+
+static std::string getProgramBinaryFile(Resource vsRes, Resource fsRes) {
+  static GLint formats = -1;
+  static std::string directory;
+  if (formats < 0) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    directory = Platform::getCachePath("ProgramCache");
+  }
+  if (!formats || directory.empty()) {
+    return std::string();
+  }
+  return directory +
+    Files::flatten(Platform::getResourcePath(vsRes)) + "+" +
+    Files::flatten(Platform::getResourcePath(fsRes)) + ".bin";
+}
+
+static uint64_t getProgramKey(const std::string & vsSource, const std::string & fsSource) {
+  uint64_t key = Platform::hash(vsSource.data(), vsSource.size());
+  key = Platform::hash(fsSource.data(), fsSource.size(), key);
+  // An include can change without either main source changing
+  for (int i = 0; SHADER_INCLUDES[i] != NO_RESOURCE; ++i) {
+    std::string include = GlUtils::getShaderSource(SHADER_INCLUDES[i]);
+    key = Platform::hash(include.data(), include.size(), key);
+  }
+  GLenum driverStrings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+  for (int i = 0; i < 3; ++i) {
+    const char * driver = (const char *)glGetString(driverStrings[i]);
+    if (driver) {
+      key = Platform::hash(driver, strlen(driver), key);
+    }
+  }
+  return key;
+}
+
+// Returns an empty pointer if there's no usable binary
+static ProgramPtr loadProgramBinary(const std::string & filename, uint64_t key) {
+  if (filename.empty()) {
+    return ProgramPtr();
+  }
+  MappedFile file(filename);
+  if (!file.isValid() || file.size() < sizeof(ProgramBinaryHeader)) {
+    return ProgramPtr();
+  }
+  const ProgramBinaryHeader & header = *(const ProgramBinaryHeader *)file.data();
+  if (PROGRAM_BINARY_MAGIC != header.magic ||
+    PROGRAM_BINARY_VERSION != header.version ||
+    key != header.key ||
+    file.size() != sizeof(ProgramBinaryHeader) + header.length) {
+    return ProgramPtr();
+  }
+
+  ProgramPtr program(new Program());
+  GLuint name = GetName(*program);
+  glProgramBinary(name, header.format, file.data() + sizeof(ProgramBinaryHeader), header.length);
+  GLint linked = GL_FALSE;
+  glGetProgramiv(name, GL_LINK_STATUS, &linked);
+  if (!linked) {
+    // Drivers may reject binaries from an older build of themselves
+    SAY("Program binary %s rejected, compiling from source", filename.c_str());
+    return ProgramPtr();
+  }
+  return program;
+}
+
+static void saveProgramBinary(Program & program, const std::string & filename, uint64_t key) {
+  if (filename.empty()) {
+    return;
+  }
+  GLuint name = GetName(program);
+  GLint length = 0;
+  glGetProgramiv(name, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return;
+  }
+  std::vector<uint8_t> data(sizeof(ProgramBinaryHeader) + length);
+  ProgramBinaryHeader & header = *(ProgramBinaryHeader *)data.data();
+  header.magic = PROGRAM_BINARY_MAGIC;
+  header.version = PROGRAM_BINARY_VERSION;
+  header.key = key;
+  GLenum format = 0;
+  glGetProgramBinary(name, length, &length, &format, data.data() + sizeof(ProgramBinaryHeader));
+  header.format = format;
+  header.length = length;
+  data.resize(sizeof(ProgramBinaryHeader) + length);
+  if (!Files::replace(filename, data.data(), data.size())) {
+    SAY_ERR("Unable to save program binary %s", filename.c_str());
+  }
+}
+
+// The sum of the include generations, which changes whenever any of them
+// does
+static uint32_t getIncludesGeneration() {
+  uint32_t result = 0;
+  for (int i = 0; SHADER_INCLUDES[i] != NO_RESOURCE; ++i) {
+    result += ResourceWatcher::getGeneration(SHADER_INCLUDES[i]);
+  }
+  return result;
+}
+
 struct ProgramInfo {
-  time_t vsModified{ 0 };
-  time_t fsModified{ 0 };
+  uint32_t vsGeneration{ 0 };
+  uint32_t fsGeneration{ 0 };
+  uint32_t includesGeneration{ 0 };
+  // Lookups since the last GlUtils::reportResourceUse
+  uint32_t uses{ 0 };
   ProgramPtr program;
 
-  void update(Resource vsRes, Resource fsRes) {
-    time_t vsModifiedNew = Platform::getResourceModified(vsRes);
-    time_t fsModifiedNew = Platform::getResourceModified(fsRes);
-    if (!program || vsModifiedNew < vsModified || fsModified < fsModifiedNew) {
-      vsModified = vsModifiedNew;
-      fsModified = fsModifiedNew;
+  void update(Resource vsRes, Resource fsRes, uint32_t includesGenerationNew) {
+    uint32_t vsGenerationNew = ResourceWatcher::getGeneration(vsRes);
+    uint32_t fsGenerationNew = ResourceWatcher::getGeneration(fsRes);
+    if (!program || vsGenerationNew != vsGeneration || fsGenerationNew != fsGeneration ||
+        includesGenerationNew != includesGeneration) {
+      vsGeneration = vsGenerationNew;
+      fsGeneration = fsGenerationNew;
+      includesGeneration = includesGenerationNew;
+      int64_t start = Platform::elapsedNanos();
+      std::string vsSource = GlUtils::getShaderSource(vsRes);
+      std::string fsSource = GlUtils::getShaderSource(fsRes);
+      std::string binaryFile = getProgramBinaryFile(vsRes, fsRes);
+      uint64_t key = getProgramKey(vsSource, fsSource);
+      ProgramPtr cached = loadProgramBinary(binaryFile, key);
+      if (cached) {
+        program = cached;
+        SAY("%s + %s: loaded binary in %.2f ms",
+          Platform::getResourcePath(vsRes).c_str(), Platform::getResourcePath(fsRes).c_str(),
+          (double)(Platform::elapsedNanos() - start) / 1e6);
+        return;
+      }
+
       VertexShader vs;
       FragmentShader fs;
       try {
-        vs.Source(Platform::getResourceString(vsRes)).Compile();
-        fs.Source(Platform::getResourceString(fsRes)).Compile();
+        vs.Source(vsSource).Compile();
+        fs.Source(fsSource).Compile();
       } catch (const oglplus::CompileError & shaderError) {
         const char * errorLog = shaderError.Log().c_str();
         if (!program) {
@@ -160,27 +293,81 @@ struct ProgramInfo {
       }
 
       program = ProgramPtr(new Program());
+      glProgramParameteri(GetName(*program), GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
       // attach the shaders to the program
       program->AttachShader(vs);
       program->AttachShader(fs);
       // link and use it
       program->Link();
+      saveProgramBinary(*program, binaryFile, key);
+      SAY("%s + %s: compiled in %.2f ms",
+        Platform::getResourcePath(vsRes).c_str(), Platform::getResourcePath(fsRes).c_str(),
+        (double)(Platform::elapsedNanos() - start) / 1e6);
     }
   }
 };
 
 
-typedef std::map<ProgramId, ProgramInfo> ProgramMap;
-typedef ProgramMap::iterator MapItr;
+struct ShaderSource {
+  uint32_t generation{ 0 };
+  std::string text;
+};
+
+static boost::mutex shaderSourceMutex;
+static std::map<Resource, ShaderSource> shaderSources;
+
+std::string GlUtils::getShaderSource(Resource resource) {
+  uint32_t generation = ResourceWatcher::getGeneration(resource);
+  std::string result;
+  bool found = false;
+  withScopedLock(shaderSourceMutex, [&](const boost::mutex::scoped_lock &){
+    std::map<Resource, ShaderSource>::iterator itr = shaderSources.find(resource);
+    if (shaderSources.end() != itr && itr->second.generation == generation) {
+      result = itr->second.text;
+      found = true;
+    }
+  });
+  if (!found) {
+    // Read outside the lock, so other threads aren't held up by the disk
+    result = Platform::getResourceString(resource);
+    withScopedLock(shaderSourceMutex, [&](const boost::mutex::scoped_lock &){
+      ShaderSource & source = shaderSources[resource];
+      source.generation = generation;
+      source.text = result;
+    });
+  }
+  return result;
+}
+
+void GlUtils::preloadShaderIncludes() {
+  for (int i = 0; SHADER_INCLUDES[i] != NO_RESOURCE; ++i) {
+    getShaderSource(SHADER_INCLUDES[i]);
+  }
+}
+
+static Registry<ProgramId, ProgramInfo> programs;
+
+ProgramHandle GlUtils::getProgramHandle(Resource vsRes, Resource fsRes) {
+  return ProgramHandle(programs.resolve(ProgramId(vsRes, fsRes)));
+}
 
 Program & GlUtils::getProgram(Resource vsRes, Resource fsRes) {
+  return getProgram(getProgramHandle(vsRes, fsRes));
+}
+
+Program & GlUtils::getProgram(ProgramHandle handle) {
+  // Registered again whenever one of them changes, which also rebuilds
+  // every program
   static bool shadersChecked = false;
-  if (!shadersChecked) {
+  static uint32_t includesGeneration = 0;
+  uint32_t includesGenerationNew = getIncludesGeneration();
+  if (!shadersChecked || includesGenerationNew != includesGeneration) {
     shadersChecked = true;
+    includesGeneration = includesGenerationNew;
     for (int i = 0; SHADER_INCLUDES[i] != NO_RESOURCE; ++i) {
       Resource shader = SHADER_INCLUDES[i];
       std::string shaderPath = Platform::getResourcePath(shader);
-      std::string shaderSource = Platform::getResourceString(shader);
+      std::string shaderSource = getShaderSource(shader);
 
       glNamedStringARB(GL_SHADER_INCLUDE_ARB,
         shaderPath.length(), shaderPath.c_str(),
@@ -190,12 +377,10 @@ Program & GlUtils::getProgram(Resource vsRes, Resource fsRes) {
     //compileShaders<VertexShader>(Resources::VERTEX_SHADERS);
     //compileShaders<FragmentShader>(Resources::FRAGMENT_SHADERS);
   }
-  static ProgramMap programs;
-  ProgramId key(vsRes, fsRes);
-  if (0 == programs.count(key)) {
-  }
-  ProgramInfo & programInfo = programs[key];
-  programInfo.update(vsRes, fsRes);
+  const ProgramId & key = programs.key(handle.index);
+  ProgramInfo & programInfo = programs[handle.index];
+  programInfo.update(key.first, key.second, includesGeneration);
+  ++programInfo.uses;
   return *programInfo.program;
 }
 
@@ -207,9 +392,35 @@ images::PNGImage getResourceImage(Resource res) {
   return images::PNGImage(stream);
 }
 
+typedef std::shared_ptr<images::PNGImage> ImagePtr;
+typedef std::vector<ImagePtr> CubemapImages;
+
+static boost::mutex cubemapImageMutex;
+static std::map<Resource, CubemapImages> cubemapImages;
+
+static void decodeCubemapImages(Resource firstResource, CubemapImages & faces) {
+  faces.resize(6);
+  for (int i = 0; i != 6; ++i) {
+    Resource image = static_cast<Resource>(firstResource + i);
+    faces[i] = ImagePtr(new images::PNGImage(getResourceImage(image)));
+  }
+}
+
+void GlUtils::preloadCubemapImages(Resource firstResource) {
+  CubemapImages faces;
+  decodeCubemapImages(firstResource, faces);
+  withScopedLock(cubemapImageMutex, [&](const boost::mutex::scoped_lock &){
+    cubemapImages[firstResource].swap(faces);
+  });
+}
+
 Texture & GlUtils::getCubemapTexture(Resource firstResource) {
   typedef std::unique_ptr<Texture> TexturePtr;
-  typedef std::map<Resource, TexturePtr> Map;
+  struct CubemapInfo {
+    TexturePtr texture;
+    uint32_t generation{ 0 };
+  };
+  typedef std::map<Resource, CubemapInfo> Map;
   typedef Map::iterator MapItr;
   static Map skyboxMap;
 
@@ -222,14 +433,33 @@ Texture & GlUtils::getCubemapTexture(Resource firstResource) {
     4, // GL_TEXTURE_CUBE_MAP_POSITIVE_Z,
   };
 
+  uint32_t generation = 0;
+  for (int i = 0; i != 6; ++i) {
+    generation += ResourceWatcher::getGeneration(static_cast<Resource>(firstResource + i));
+  }
+
   MapItr itr = skyboxMap.find(firstResource);
   if (skyboxMap.end() != itr) {
-    return *(itr->second);
+    if (itr->second.generation == generation) {
+      return *(itr->second.texture);
+    }
+    // A face changed, so decode them all again
+    itr->second.generation = generation;
+    Texture & texture = *(itr->second.texture);
+    CubemapImages faces;
+    decodeCubemapImages(firstResource, faces);
+    auto textureBinding = context().Bound(Texture::Target::CubeMap, texture);
+    for (int i = 0; i != 6; ++i) {
+      Texture::CubeMapFace(RESOURCE_ORDER[i]) << *faces[i];
+    }
+    return texture;
   }
 
   Context & gl = context();
-  skyboxMap[firstResource].reset(new Texture());
-  Texture & texture = *(skyboxMap[firstResource]);
+  CubemapInfo & info = skyboxMap[firstResource];
+  info.texture.reset(new Texture());
+  info.generation = generation;
+  Texture & texture = *(info.texture);
   auto textureBinding = gl.Bound(Texture::Target::CubeMap, texture);
   textureBinding
     .MinFilter(TextureMinFilter::Nearest)
@@ -239,203 +469,425 @@ Texture & GlUtils::getCubemapTexture(Resource firstResource) {
     .WrapR(TextureWrap::ClampToEdge);
   GL_CHECK_ERROR;
 
-  std::vector<uint8_t> data;
-  uvec2 size;
+  CubemapImages faces;
+  withScopedLock(cubemapImageMutex, [&](const boost::mutex::scoped_lock &){
+    std::map<Resource, CubemapImages>::iterator itr = cubemapImages.find(firstResource);
+    if (cubemapImages.end() != itr) {
+      faces.swap(itr->second);
+      cubemapImages.erase(itr);
+    }
+  });
+  if (faces.empty()) {
+    decodeCubemapImages(firstResource, faces);
+  }
   for (int i = 0; i != 6; ++i) {
-    Resource image = static_cast<Resource>(firstResource + i);
-    Texture::CubeMapFace(RESOURCE_ORDER[i]) << getResourceImage(image);
+    Texture::CubeMapFace(RESOURCE_ORDER[i]) << *faces[i];
     GL_CHECK_ERROR;
   }
   return texture;
 }
 
 
-Geometry & GlUtils::getColorCubeGeometry() {
-  static Geometry cube;
-  static bool initialized = false;
-  if (!initialized) {
-    Mesh mesh;
-    vec3 move(0, 0, 0.5f);
-    MatrixStack & m = mesh.model;
-
-    m.push().rotate(glm::angleAxis(PI / 2.0f, Y_AXIS)).translate(move);
-    mesh.color = Colors::red;
-    mesh.addQuad(vec2(1.0));
-    mesh.fillColors(true);
-    m.pop();
-
-    m.push().rotate(glm::angleAxis(-PI / 2.0f, X_AXIS)).translate(move);
-    mesh.color = Colors::green;
-    mesh.addQuad(vec2(1.0));
-    m.pop();
-
-    m.push().translate(move);
-    mesh.color = Colors::blue;
-    mesh.addQuad(vec2(1.0));
-    m.pop();
-
-    m.push().rotate(glm::angleAxis(-PI / 2.0f, Y_AXIS)).translate(move);
-    mesh.color = Colors::cyan;
-    mesh.addQuad(vec2(1.0));
-    m.pop();
-
-    m.push().rotate(glm::angleAxis(PI / 2.0f, X_AXIS)).translate(move);
-    mesh.color = Colors::yellow;
-    mesh.addQuad(vec2(1.0));
-    m.pop();
-
-    m.push().rotate(glm::angleAxis(-PI, X_AXIS)).translate(move);
-    mesh.color = Colors::magenta;
-    mesh.addQuad(vec2(1.0));
-    m.pop();
-    cube.loadMesh(mesh);
-  }
-  return cube;
+void GlUtils::getColorCubeMesh(Mesh & mesh) {
+  vec3 move(0, 0, 0.5f);
+  MatrixStack & m = mesh.model;
+
+  m.push().rotate(glm::angleAxis(PI / 2.0f, Y_AXIS)).translate(move);
+  mesh.color = Colors::red;
+  mesh.addQuad(vec2(1.0));
+  mesh.fillColors(true);
+  m.pop();
+
+  m.push().rotate(glm::angleAxis(-PI / 2.0f, X_AXIS)).translate(move);
+  mesh.color = Colors::green;
+  mesh.addQuad(vec2(1.0));
+  m.pop();
+
+  m.push().translate(move);
+  mesh.color = Colors::blue;
+  mesh.addQuad(vec2(1.0));
+  m.pop();
+
+  m.push().rotate(glm::angleAxis(-PI / 2.0f, Y_AXIS)).translate(move);
+  mesh.color = Colors::cyan;
+  mesh.addQuad(vec2(1.0));
+  m.pop();
+
+  m.push().rotate(glm::angleAxis(PI / 2.0f, X_AXIS)).translate(move);
+  mesh.color = Colors::yellow;
+  mesh.addQuad(vec2(1.0));
+  m.pop();
+
+  m.push().rotate(glm::angleAxis(-PI, X_AXIS)).translate(move);
+  mesh.color = Colors::magenta;
+  mesh.addQuad(vec2(1.0));
+  m.pop();
 }
 
 const float GlUtils::CHESS_SCALE = 0.055f;
 
-Geometry & GlUtils::getChessBoardGeometry() {
-  static Geometry chess;
-  static bool initialized = false;
-  if (!initialized) {
-    Mesh mesh;
-    vec3 move(0, 0, 0.5f);
-    MatrixStack & m = mesh.model;
-    m.scale(CHESS_SCALE);
-    m.rotate(PI / 2, X_AXIS);
-    m.translate(vec3(-3.5, -3.5, 0));
-    for (int x = 0; x < 8; ++x) {
-      for (int y = 0; y < 8; ++y) {
-        m.withPush([&]{
-          m.translate(vec3(x, y, 0));
-          mesh.color = (x + y) % 2 ? Colors::saddleBrown : Colors::wheat;
-          mesh.addQuad(vec2(1.0));
-          mesh.fillColors(true);
-        });
-      }
+// Indexed by Chess::PieceType
+const Resource GlUtils::PIECE_RESOURCES[Chess::PieceType::COUNT] = {
+  Resource::MESHES_CHESS_PAWN_CTM,
+  Resource::MESHES_CHESS_ROOK_CTM,
+  Resource::MESHES_CHESS_KNIGHT_CTM,
+  Resource::MESHES_CHESS_BISHOP_CTM,
+  Resource::MESHES_CHESS_QUEEN_CTM,
+  Resource::MESHES_CHESS_KING_CTM,
+};
+
+void GlUtils::getChessBoardMesh(Mesh & mesh) {
+  MatrixStack & m = mesh.model;
+  m.scale(CHESS_SCALE);
+  m.rotate(PI / 2, X_AXIS);
+  m.translate(vec3(-3.5, -3.5, 0));
+  for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 8; ++y) {
+      m.withPush([&]{
+        m.translate(vec3(x, y, 0));
+        mesh.color = (x + y) % 2 ? Colors::saddleBrown : Colors::wheat;
+        mesh.addQuad(vec2(1.0));
+        mesh.fillColors(true);
+      });
     }
-    chess.loadMesh(mesh);
   }
-  return chess;
 }
 
-void Geometry::loadMesh(const Mesh & mesh) {
-  {
-    using namespace oglplus;
-    size_t attributeCount = 1;
-    if (!mesh.normals.empty()) {
-      attributeCount++;
-    }
-    if (!mesh.colors.empty()) {
-      attributeCount++;
-    }
-    if (!mesh.texCoords.empty()) {
-      attributeCount++;
-    }
+VertexLayout::VertexLayout(const Mesh & mesh, bool packed) :
+  normals(!mesh.normals.empty()),
+  colors(!mesh.colors.empty()),
+  texCoords(!mesh.texCoords.empty()),
+  packed(packed) {
+}
 
-    GLsizei stride = attributeCount * 4 * sizeof(GLfloat);
-    {
-      size_t vertexCount = mesh.positions.size();
-      VVec4 vertices;
-      vertices.reserve(vertexCount * attributeCount);
-      for (size_t i = 0; i < vertexCount; ++i) {
-        vertices.push_back(mesh.positions[i]);
-        if (!mesh.normals.empty()) {
-          vertices.push_back(mesh.normals[i]);
-        }
-        if (!mesh.colors.empty()) {
-          vertices.push_back(vec4(mesh.colors[i], 1));
-        }
-        if (!mesh.texCoords.empty()) {
-          vertices.push_back(vec4(mesh.texCoords[i], 1, 1));
-        }
+GLsizei VertexLayout::attributeCount() const {
+  return 1 + (normals ? 1 : 0) + (colors ? 1 : 0) + (texCoords ? 1 : 0);
+}
+
+GLsizei VertexLayout::stride() const {
+  if (!packed) {
+    return attributeCount() * 4 * sizeof(GLfloat);
+  }
+  // Every packed attribute past the position is 4 bytes
+  return 3 * sizeof(GLfloat) + (attributeCount() - 1) * sizeof(GLuint);
+}
+
+static GLuint packNormal(const vec4 & normal) {
+  vec3 n = glm::clamp(vec3(normal), vec3(-1), vec3(1));
+  GLuint x = (GLint)glm::round(n.x * 511.0f) & 0x3FF;
+  GLuint y = (GLint)glm::round(n.y * 511.0f) & 0x3FF;
+  GLuint z = (GLint)glm::round(n.z * 511.0f) & 0x3FF;
+  return x | (y << 10) | (z << 20);
+}
+
+static GLuint packColor(const vec3 & color) {
+  glm::uvec3 c = glm::uvec3(glm::round(glm::clamp(color, vec3(0), vec3(1)) * 255.0f));
+  return c.r | (c.g << 8) | (c.b << 16) | (0xFFu << 24);
+}
+
+template <typename T>
+static void append(std::vector<uint8_t> & out, const T & value) {
+  const uint8_t * bytes = (const uint8_t *)&value;
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void VertexLayout::interleave(const Mesh & mesh, std::vector<uint8_t> & vertices) const {
+  size_t vertexCount = mesh.positions.size();
+  vertices.reserve(vertices.size() + vertexCount * stride());
+  for (size_t i = 0; i < vertexCount; ++i) {
+    vec4 normal = mesh.normals.empty() ? vec4(0, 1, 0, 1) : mesh.normals[i];
+    vec3 color = mesh.colors.empty() ? vec3(1) : mesh.colors[i];
+    vec2 texCoord = mesh.texCoords.empty() ? vec2(0) : mesh.texCoords[i];
+    if (!packed) {
+      append(vertices, mesh.positions[i]);
+      if (normals) {
+        append(vertices, normal);
       }
-      Context().Bound(Buffer::Target::Array, vertexBuffer).Data(vertices);
+      if (colors) {
+        append(vertices, vec4(color, 1));
+      }
+      if (texCoords) {
+        append(vertices, vec4(texCoord, 1, 1));
+      }
+      continue;
     }
-    Context().Bound(Buffer::Target::ElementArray, indexBuffer).Data(mesh.indices);
-    elements = mesh.indices.size();
 
-    GLsizei offset = 0;
-    vao.Bind();
-    vertexBuffer.Bind(Buffer::Target::Array);
-    indexBuffer.Bind(Buffer::Target::ElementArray);
+    append(vertices, vec3(mesh.positions[i]));
+    if (normals) {
+      append(vertices, packNormal(normal));
+    }
+    if (colors) {
+      append(vertices, packColor(color));
+    }
+    if (texCoords) {
+      append(vertices, (GLuint)glm::packHalf2x16(texCoord));
+    }
+  }
+}
 
+void VertexLayout::setupAttributes() const {
+  using namespace oglplus;
+  GLsizei stride = this->stride();
+  GLsizei offset = 0;
+  if (!packed) {
     // setup the vertex attribs array for the vertices
     VertexArrayAttrib(Layout::Attribute::Position).
       Pointer(3, DataType::Float, false, stride, (void*)offset).
       Enable();
 
     offset += (sizeof(GLfloat) * 4);
-    if (!mesh.normals.empty()) {
+    if (normals) {
       VertexArrayAttrib(Layout::Attribute::Normal).
         Pointer(3, DataType::Float, false, stride, (void*)offset).
         Enable();
       offset += (sizeof(GLfloat) * 4);
     }
-    if (!mesh.colors.empty()) {
+    if (colors) {
       VertexArrayAttrib(Layout::Attribute::Color).
         Pointer(3, DataType::Float, false, stride, (void*)offset).
         Enable();
       offset += (sizeof(GLfloat) * 4);
     }
-    if (!mesh.texCoords.empty()) {
+    if (texCoords) {
       VertexArrayAttrib(Layout::Attribute::TexCoord0).
         Pointer(2, DataType::Float, false, stride, (void*)offset).
         Enable();
       offset += (sizeof(GLfloat) * 4);
     }
-    NoVertexArray().Bind();
-    NoBuffer().Bind(Buffer::Target::Array);
-    NoBuffer().Bind(Buffer::Target::ElementArray);
+    return;
+  }
+
+  // The packed types aren't all covered by oglplus::DataType
+  glVertexAttribPointer(Layout::Attribute::Position, 3, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+  glEnableVertexAttribArray(Layout::Attribute::Position);
+  offset += sizeof(GLfloat) * 3;
+  if (normals) {
+    glVertexAttribPointer(Layout::Attribute::Normal, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offset);
+    glEnableVertexAttribArray(Layout::Attribute::Normal);
+    offset += sizeof(GLuint);
   }
+  if (colors) {
+    glVertexAttribPointer(Layout::Attribute::Color, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offset);
+    glEnableVertexAttribArray(Layout::Attribute::Color);
+    offset += sizeof(GLuint);
+  }
+  if (texCoords) {
+    glVertexAttribPointer(Layout::Attribute::TexCoord0, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offset);
+    glEnableVertexAttribArray(Layout::Attribute::TexCoord0);
+    offset += sizeof(GLuint);
+  }
+}
+
+void VertexLayout::setupInstanceAttributes(bool instanceColor) {
+  for (int i = 0; i < 4; ++i) {
+    GLuint attribute = Layout::Attribute::InstanceTransform + i;
+    glVertexAttribFormat(attribute, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, transform) + sizeof(vec4) * i);
+    glVertexAttribBinding(attribute, Layout::Binding::Instance);
+    glEnableVertexAttribArray(attribute);
+  }
+  if (instanceColor) {
+    glVertexAttribFormat(Layout::Attribute::InstanceColor, 4, GL_FLOAT, GL_FALSE, offsetof(InstanceData, color));
+    glVertexAttribBinding(Layout::Attribute::InstanceColor, Layout::Binding::Instance);
+    glEnableVertexAttribArray(Layout::Attribute::InstanceColor);
+  }
+  glVertexBindingDivisor(Layout::Binding::Instance, 1);
 }
 
+int Geometry::viewCount = 1;
+uint64_t Geometry::drawCalls = 0;
+
+void Geometry::loadMesh(const Mesh & mesh, bool packed) {
+  using namespace oglplus;
+  VertexLayout layout(mesh, packed);
+  vertexBytes = 0;
+  {
+    std::vector<uint8_t> vertices;
+    layout.interleave(mesh, vertices);
+    Context().Bound(Buffer::Target::Array, vertexBuffer).Data(vertices);
+    vertexBytes = vertices.size();
+  }
+  indexType = uploadIndices(indexBuffer, mesh.indices, mesh.positions.size());
+  elements = mesh.indices.size();
+  bounds = Bounds::of(mesh);
+
+  vao.Bind();
+  vertexBuffer.Bind(Buffer::Target::Array);
+  indexBuffer.Bind(Buffer::Target::ElementArray);
+  layout.setupAttributes();
+  NoVertexArray().Bind();
+  NoBuffer().Bind(Buffer::Target::Array);
+  NoBuffer().Bind(Buffer::Target::ElementArray);
+}
+
+GLenum Geometry::uploadIndices(oglplus::Buffer & buffer, const std::vector<GLuint> & indices, size_t vertexCount) {
+  using namespace oglplus;
+  if (vertexCount > 0x10000) {
+    Context().Bound(Buffer::Target::ElementArray, buffer).Data(indices);
+    return GL_UNSIGNED_INT;
+  }
+  std::vector<GLushort> shortIndices(indices.begin(), indices.end());
+  Context().Bound(Buffer::Target::ElementArray, buffer).Data(shortIndices);
+  return GL_UNSIGNED_SHORT;
+}
+
+void Geometry::loadMesh(const CachedMesh & mesh) {
+  const MeshCacheHeader & header = mesh.header();
+  vertexBytes = header.vertexBytes;
+  indexType = header.indexType;
+  elements = header.indexCount;
+  bounds = mesh.bounds();
+
+  vao.Bind();
+  vertexBuffer.Bind(oglplus::Buffer::Target::Array);
+  glBufferData(GL_ARRAY_BUFFER, header.vertexBytes, mesh.vertices(), GL_STATIC_DRAW);
+  indexBuffer.Bind(oglplus::Buffer::Target::ElementArray);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, header.indexBytes, mesh.indices(), GL_STATIC_DRAW);
+  mesh.layout().setupAttributes();
+  oglplus::NoVertexArray().Bind();
+  oglplus::NoBuffer().Bind(oglplus::Buffer::Target::Array);
+  oglplus::NoBuffer().Bind(oglplus::Buffer::Target::ElementArray);
+}
+
+void Geometry::enableInstancing(bool instanceColor) {
+  if (instanced) {
+    return;
+  }
+  instanced = true;
+  vao.Bind();
+  VertexLayout::setupInstanceAttributes(instanceColor);
+  oglplus::NoVertexArray().Bind();
+}
+
+void GlUtils::loadCtmMesh(Resource resource, Mesh & mesh) {
+  CTMimporter importer;
+  importer.LoadData(Platform::getResourceString(resource));
+  int vertexCount = importer.GetInteger(CTM_VERTEX_COUNT);
+  mesh.positions.resize(vertexCount);
+  const float * ctmData = importer.GetFloatArray(CTM_VERTICES);
+  for (int i = 0; i < vertexCount; ++i) {
+    glm::vec4 pos(glm::make_vec3(ctmData + (i * 3)), 1);
+    pos = mesh.model.top() * pos;
+    pos /= pos.w;
+    mesh.positions[i] = vec4(glm::make_vec3(&pos.x), 1);
+  }
+
+  if (importer.GetInteger(CTM_UV_MAP_COUNT) > 0) {
+    const float * ctmData = importer.GetFloatArray(CTM_UV_MAP_1);
+    mesh.texCoords.resize(vertexCount);
+    for (int i = 0; i < vertexCount; ++i) {
+      mesh.texCoords[i] = glm::make_vec2(ctmData + (i * 2));
+    }
+  }
+
+  bool hasNormals = importer.GetInteger(CTM_HAS_NORMALS) ? true : false;
+  if (hasNormals) {
+    mesh.normals.resize(vertexCount);
+    ctmData = importer.GetFloatArray(CTM_NORMALS);
+    for (int i = 0; i < vertexCount; ++i) {
+      mesh.normals[i] = vec4(glm::make_vec3(ctmData + (i * 3)), 1);
+    }
+  }
+
+  int indexCount = 3 * importer.GetInteger(CTM_TRIANGLE_COUNT);
+  const CTMuint * ctmIntData = importer.GetIntegerArray(CTM_INDICES);
+  mesh.indices.resize(indexCount);
+  for (int i = 0; i < indexCount; ++i) {
+    mesh.indices[i] = *(ctmIntData + i);
+  }
+  MeshOptimizer::optimize(mesh, Platform::getResourcePath(resource));
+}
+
+typedef std::shared_ptr<Geometry> GeometryPtr;
+
+struct GeometryInfo {
+  GeometryPtr geometry;
+  uint32_t generation{ 0 };
+  uint32_t uses{ 0 };
+};
+
+static Registry<Resource, GeometryInfo> geometries;
+
+GeometryHandle GlUtils::getGeometryHandle(Resource resource) {
+  return GeometryHandle(geometries.resolve(resource));
+}
 
 Geometry & GlUtils::getGeometry(Resource resource) {
-  typedef std::shared_ptr<Geometry> GeometryPtr;
-  typedef std::map<Resource, GeometryPtr> Map;
-  static Map map;
-  if (!map.count(resource)) {
-    map[resource].reset(new Geometry());
-    Mesh mesh; {
-      CTMimporter importer;
-      importer.LoadData(Platform::getResourceString(resource));
-      int vertexCount = importer.GetInteger(CTM_VERTEX_COUNT);
-      mesh.positions.resize(vertexCount);
-      const float * ctmData = importer.GetFloatArray(CTM_VERTICES);
-      for (int i = 0; i < vertexCount; ++i) {
-        glm::vec4 pos(glm::make_vec3(ctmData + (i * 3)), 1);
-        pos = mesh.model.top() * pos;
-        pos /= pos.w;
-        mesh.positions[i] = vec4(glm::make_vec3(&pos.x), 1);
-      }
+  return getGeometry(getGeometryHandle(resource));
+}
 
-      if (importer.GetInteger(CTM_UV_MAP_COUNT) > 0) {
-        const float * ctmData = importer.GetFloatArray(CTM_UV_MAP_1);
-        mesh.texCoords.resize(vertexCount);
-        for (int i = 0; i < vertexCount; ++i) {
-          mesh.texCoords[i] = glm::make_vec2(ctmData + (i * 2));
-        }
-      }
+Geometry & GlUtils::getGeometry(GeometryHandle handle) {
+  Resource resource = geometries.key(handle.index);
+  uint32_t generation = ResourceWatcher::getGeneration(resource);
+  GeometryInfo & info = geometries[handle.index];
+  if (!info.geometry || info.generation != generation) {
+    // Reloads in place, so references handed out earlier stay valid
+    if (!info.geometry) {
+      info.geometry.reset(new Geometry());
+    }
+    info.generation = generation;
+    info.geometry->loadMesh(*MeshCache::load(resource));
+  }
+  ++info.uses;
+  return *info.geometry;
+}
 
-      bool hasNormals = importer.GetInteger(CTM_HAS_NORMALS) ? true : false;
-      if (hasNormals) {
-        mesh.normals.resize(vertexCount);
-        ctmData = importer.GetFloatArray(CTM_NORMALS);
-        for (int i = 0; i < vertexCount; ++i) {
-          mesh.normals[i] = vec4(glm::make_vec3(ctmData + (i * 3)), 1);
-        }
-      }
+void GlUtils::reportResourceUse() {
+  for (int i = 0; i < programs.size(); ++i) {
+    const ProgramId & key = programs.key(i);
+    ProgramInfo & info = programs[i];
+    SAY("Program %d (%s + %s): %d uses", i,
+      Platform::getResourcePath(key.first).c_str(),
+      Platform::getResourcePath(key.second).c_str(), info.uses);
+    info.uses = 0;
+  }
+  for (int i = 0; i < geometries.size(); ++i) {
+    GeometryInfo & info = geometries[i];
+    SAY("Geometry %d (%s): %d uses", i,
+      Platform::getResourcePath(geometries.key(i)).c_str(), info.uses);
+    info.uses = 0;
+  }
+}
 
-      int indexCount = 3 * importer.GetInteger(CTM_TRIANGLE_COUNT);
-      const CTMuint * ctmIntData = importer.GetIntegerArray(CTM_INDICES);
-      mesh.indices.resize(indexCount);
-      for (int i = 0; i < indexCount; ++i) {
-        mesh.indices[i] = *(ctmIntData + i);
+const VertexLayout GlUtils::SHARED_MESH_LAYOUT(true, true, false);
+
+MeshBuffer & GlUtils::getSharedMeshes() {
+  static MeshBuffer meshes(SHARED_MESH_LAYOUT);
+  static bool initialized = false;
+  static uint32_t piecesGeneration = 0;
+  uint32_t generation = 0;
+  for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+    generation += ResourceWatcher::getGeneration(PIECE_RESOURCES[type]);
+  }
+  if (!initialized || generation != piecesGeneration) {
+    // Rebuilt in place.  Users holding ranges or commands check
+    // MeshBuffer::version.
+    if (initialized) {
+      meshes.clear();
+    }
+    initialized = true;
+    piecesGeneration = generation;
+    int64_t start = Platform::elapsedNanos();
+    for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+      meshes.add(PIECE_RESOURCES[type]);
+    }
+    {
+      Mesh mesh;
+      getChessBoardMesh(mesh);
+      meshes.add(mesh);
+    }
+    {
+      Mesh mesh;
+      getColorCubeMesh(mesh);
+      meshes.add(mesh);
+    }
+    for (int lod = 1; lod < SharedMesh::PIECE_LODS; ++lod) {
+      for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+        meshes.add(PIECE_RESOURCES[type], lod);
       }
     }
-    map[resource]->loadMesh(mesh);
+    meshes.upload();
+    meshes.enableInstancing();
+    SAY("Shared meshes loaded in %.2f ms", (double)(Platform::elapsedNanos() - start) / 1e6);
   }
-  return (*map[resource]);
+  return meshes;
 }
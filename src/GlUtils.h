@@ -69,44 +69,79 @@ namespace Layout {
       Normal = 2,
       Color = 3,
       TexCoord1 = 4,
+      // A mat4, so it also uses locations 6 to 8
       InstanceTransform = 5,
+      InstanceColor = 9,
     };
   }
 
+  // Vertex buffer binding points for attributes that aren't set up with
+  // glVertexAttribPointer, which implicitly uses the attribute's location
+  namespace Binding {
+    enum {
+      Instance = 15,
+    };
+  }
+
+  // Uniforms outside of the shared blocks
   namespace Uniform {
     enum {
-      Projection = 0,
-      ModelView = 1,
-      NormalMatrix = 2,
       Time = 3,
-      Color = 4,
-      LightAmbient = 8,
-      LightCount = 9,
-      ForceAlpha = 10,
-      LightPosition = 16,
-      LightColor = 24,
+      MultiresSplits = 4,
+      MultiresPackedX = 5,
+      MultiresPackedY = 6,
     };
   }
-}
 
-#define SET_UNIFORM(p, u, t, v) \
-  oglplus::Uniform<t>(p, Layout::Uniform::u).Set(v)
+  // Binding points of the blocks in shaders/Uniforms.glsl
+  namespace UniformBlock {
+    enum {
+      Camera = 0,
+      Lighting = 1,
+      Draw = 2,
+    };
+  }
+}
 
-#define SET_PROJECTION(program) \
-  SET_UNIFORM(program, Projection, mat4, Stacks::projection().top())
+// Per instance data for the instanced shaders, read through
+// Layout::Attribute::InstanceTransform and InstanceColor
+struct InstanceData {
+  mat4 transform;
+  vec4 color;
+};
 
-#define SET_MODELVIEW(program) \
-  SET_UNIFORM(program, ModelView, mat4, Stacks::modelview().top())
+// The attributes present in an interleaved vertex, and how they're stored.
+//
+// Packed vertices hold a float3 position, a GL_INT_2_10_10_10_REV normal,
+// an RGBA8 color and half float texture coordinates, so a lit, colored
+// vertex is 20 bytes.  Unpacked vertices store every attribute as a vec4,
+// the original format, and are kept for comparison.
+struct VertexLayout {
+  bool normals{ false };
+  bool colors{ false };
+  bool texCoords{ false };
+  bool packed{ true };
+
+  VertexLayout() {
+  }
 
-#define SET_LIGHTS(program, lights) \
-  SET_UNIFORM(program, LightAmbient, vec4, lights.ambient); \
-  SET_UNIFORM(program, LightCount, int, lights.lightPositions.size()); \
-  for(size_t  i = 0; i < lights.lightPositions.size(); ++i) { \
-    SET_UNIFORM(program, LightPosition + i, vec3, lights.lightPositions[i]); \
-    SET_UNIFORM(program, LightColor + i, vec4, lights.lightColors[i]); \
+  explicit VertexLayout(const Mesh & mesh, bool packed = true);
+  VertexLayout(bool normals, bool colors, bool texCoords, bool packed = true) :
+    normals(normals), colors(colors), texCoords(texCoords), packed(packed) {
   }
 
+  GLsizei attributeCount() const;
+  GLsizei stride() const;
+  // Appends the mesh's vertices, filling in defaults for any enabled
+  // attributes the mesh doesn't have
+  void interleave(const Mesh & mesh, std::vector<uint8_t> & vertices) const;
+  // Sets up the attribute pointers on the currently bound VAO
+  void setupAttributes() const;
+  // Adds the InstanceData attributes to the currently bound VAO
+  static void setupInstanceAttributes(bool instanceColor);
+};
 
+class CachedMesh;
 
 class Geometry {
 public:
@@ -121,6 +156,22 @@ public:
 
   GLsizei elements;
   GLenum  elementType{ GL_TRIANGLES };
+  // GL_UNSIGNED_SHORT when loadMesh finds the mesh small enough
+  GLenum  indexType{ GL_UNSIGNED_INT };
+  // The size of the vertex buffer, when built with loadMesh
+  size_t  vertexBytes{ 0 };
+  // Set by loadMesh, empty otherwise
+  Bounds  bounds;
+  bool    instanced{ false };
+
+  // How many views every draw renders.  With single pass stereo this is
+  // 2, each draw is instanced twice as many times, and the vertex shader
+  // picks the eye from gl_InstanceID.  Instance attributes advance every
+  // viewCount instances, so base instances are unaffected.
+  static int viewCount;
+  // Draw calls issued through Geometry, MeshBuffer and the multi-draws,
+  // with a multi-draw counted once.  Never reset, benchmarks difference it.
+  static uint64_t drawCalls;
 
   Geometry() {
   }
@@ -134,16 +185,78 @@ public:
   }
 
   void draw() {
-    glDrawElements(elementType, elements, GL_UNSIGNED_INT, (void*)0);
+    ++drawCalls;
+    if (1 == viewCount) {
+      glDrawElements(elementType, elements, indexType, (void*)0);
+    } else {
+      glDrawElementsInstanced(elementType, elements, indexType, (void*)0, viewCount);
+    }
+  }
+
+  void drawInstanced(int count, int baseInstance = 0) {
+    ++drawCalls;
+    glDrawElementsInstancedBaseInstance(elementType, elements, indexType, (void*)0, count * viewCount, baseInstance);
   }
 
-  void drawInstanced(int count) {
-    glDrawElementsInstanced(elementType, elements, GL_UNSIGNED_INT, (void*)0, count);
+  void loadMesh(const Mesh & mesh, bool packed = true);
+  // Uploads the already interleaved data straight from the cache entry
+  void loadMesh(const CachedMesh & mesh);
+
+  // Uploads the indices as 16 bit values if every index fits, otherwise
+  // as 32 bit, and returns the type used
+  static GLenum uploadIndices(oglplus::Buffer & buffer, const std::vector<GLuint> & indices, size_t vertexCount);
+  static size_t indexSize(GLenum indexType) {
+    return GL_UNSIGNED_SHORT == indexType ? sizeof(GLushort) : sizeof(GLuint);
+  }
+
+  // Adds the InstanceData attributes to the VAO, sourced from the
+  // Layout::Binding::Instance binding point.  The buffer itself is set per
+  // draw with bindInstances, so several instance buffers can share a VAO.
+  void enableInstancing(bool instanceColor = true);
+
+  // Call with the VAO bound
+  static void bindInstances(oglplus::Buffer & buffer, GLintptr offset = 0) {
+    glBindVertexBuffer(Layout::Binding::Instance, oglplus::GetName(buffer), offset, sizeof(InstanceData));
+    glVertexBindingDivisor(Layout::Binding::Instance, viewCount);
   }
+};
+
 
-  void loadMesh(const Mesh & mesh);
+class MeshBuffer;
+
+// Dense indices into the program and geometry registries.  Resolve them
+// once, outside the frame loop; lookups by handle skip the map search.
+// Types of their own rather than ints, so an integer expression of a
+// Resource can't quietly pick a handle overload.
+struct ProgramHandle {
+  int index;
+  explicit ProgramHandle(int index) : index(index) {}
 };
 
+struct GeometryHandle {
+  int index;
+  explicit GeometryHandle(int index) : index(index) {}
+};
+
+// Ranges in GlUtils::getSharedMeshes().  The pieces come first, so a
+// Chess::PieceType is also a SharedMesh.  The simplified pieces follow
+// the primitives, see pieceLod.
+namespace SharedMesh {
+  // Levels of detail for each piece, counting the full mesh as level 0.
+  // Each level has half the triangles of the one before.
+  const int PIECE_LODS = 4;
+
+  enum {
+    CHESS_BOARD = Chess::PieceType::COUNT,
+    COLOR_CUBE,
+    FIRST_PIECE_LOD,
+    COUNT = FIRST_PIECE_LOD + (PIECE_LODS - 1) * Chess::PieceType::COUNT
+  };
+
+  inline int pieceLod(int type, int lod) {
+    return lod ? FIRST_PIECE_LOD + (lod - 1) * Chess::PieceType::COUNT + type : type;
+  }
+}
 
 class GlUtils {
 public:
@@ -151,15 +264,41 @@ public:
 
   static oglplus::Texture & getCubemapTexture(
     Resource resource);
+  // Decodes the faces for getCubemapTexture, which uploads them.  Safe to
+  // call from any thread.
+  static void preloadCubemapImages(Resource firstResource);
 
+  static ProgramHandle getProgramHandle(
+    Resource vertexResource,
+    Resource fragmentResource);
+  static oglplus::Program & getProgram(ProgramHandle handle);
   static oglplus::Program & getProgram(
     Resource vertexResource,
     Resource fragmentResource);
-
-  static Geometry & getColorCubeGeometry();
-  static Geometry & getChessBoardGeometry();
-
+  // The source is kept until the file changes.  Safe to call from any
+  // thread, so sources can be read ahead of getProgram.
+  static std::string getShaderSource(Resource resource);
+  // Reads the sources getProgram registers for #include
+  static void preloadShaderIncludes();
+
+  // Append the primitive to the mesh
+  static void getColorCubeMesh(Mesh & mesh);
+  static void getChessBoardMesh(Mesh & mesh);
+
+  static void loadCtmMesh(Resource resource, Mesh & mesh);
+  static GeometryHandle getGeometryHandle(Resource resource);
+  static Geometry & getGeometry(GeometryHandle handle);
   static Geometry & getGeometry(Resource resource);
+  // Logs how often each program and geometry was looked up since the
+  // last report, then resets the counts
+  static void reportResourceUse();
+  // The pieces, the board and the common primitives in one set of
+  // buffers and one VAO, with ranges indexed by SharedMesh
+  static MeshBuffer & getSharedMeshes();
+  // Lit pieces and colored primitives.  Loading the pieces from the
+  // MeshCache in this layout ahead of time leaves getSharedMeshes only
+  // the upload.
+  static const VertexLayout SHARED_MESH_LAYOUT;
   static void getCubeVertices(oglplus::Buffer & dest);
 
   static void getCubeIndices(oglplus::Buffer & dest);
@@ -167,6 +306,7 @@ public:
   static void getCubeWireIndices(oglplus::Buffer & dest);
 
   static const float CHESS_SCALE;
+  static const Resource PIECE_RESOURCES[Chess::PieceType::COUNT];
 
 
   static const vec3 X_AXIS;
@@ -0,0 +1,176 @@
+#include "Common.h"
+
+struct Pass {
+  const char * name;
+  boost::circular_buffer<float> samples;
+  // This frame's total so far, in nanoseconds
+  uint64_t total{ 0 };
+  // Whether the newest sample was added by the current beginFrame
+  bool fresh{ false };
+
+  Pass(const char * name) : name(name), samples(GpuTimer::HISTORY) {
+  }
+};
+
+struct ScopeQueries {
+  int pass;
+  GLuint start;
+  GLuint end;
+};
+
+// The queries issued in one frame
+struct Slot {
+  GLuint queries[GpuTimer::MAX_SCOPES * 2];
+  ScopeQueries scopes[GpuTimer::MAX_SCOPES];
+  int count{ 0 };
+};
+
+static Slot slots[GpuTimer::RING_FRAMES];
+static int slot = 0;
+static bool initialized = false;
+static std::vector<Pass> passes;
+static std::vector<GpuTimer::Stats> stats;
+static uint32_t statsVersion = 0;
+static int frames = 0;
+// Frames whose queries weren't ready in time, and were dropped rather
+// than waited for
+static int dropped = 0;
+
+static int findPass(const char * name) {
+  for (size_t i = 0; i < passes.size(); ++i) {
+    if (passes[i].name == name || !strcmp(passes[i].name, name)) {
+      return i;
+    }
+  }
+  passes.push_back(Pass(name));
+  return passes.size() - 1;
+}
+
+GpuTimer::Scope::Scope(const char * name) : scope(-1) {
+  Slot & current = slots[slot];
+  if (!initialized || current.count == MAX_SCOPES) {
+    return;
+  }
+  scope = current.count++;
+  ScopeQueries & queries = current.scopes[scope];
+  queries.pass = findPass(name);
+  queries.start = current.queries[scope * 2];
+  queries.end = current.queries[scope * 2 + 1];
+  glQueryCounter(queries.start, GL_TIMESTAMP);
+}
+
+GpuTimer::Scope::~Scope() {
+  if (scope >= 0) {
+    glQueryCounter(slots[slot].scopes[scope].end, GL_TIMESTAMP);
+  }
+}
+
+static void updateStats() {
+  stats.resize(passes.size());
+  std::vector<float> sorted;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    const Pass & pass = passes[i];
+    GpuTimer::Stats & result = stats[i];
+    result.name = pass.name;
+    if (pass.samples.empty()) {
+      continue;
+    }
+    sorted.assign(pass.samples.begin(), pass.samples.end());
+    std::sort(sorted.begin(), sorted.end());
+    float total = 0;
+    for (size_t j = 0; j < sorted.size(); ++j) {
+      total += sorted[j];
+    }
+    result.min = sorted.front();
+    result.avg = total / sorted.size();
+    result.p99 = sorted[(sorted.size() - 1) * 99 / 100];
+  }
+  ++statsVersion;
+}
+
+// Adds the slot's scopes to the history, unless they aren't all ready
+static void readSlot(Slot & frame) {
+  if (!frame.count) {
+    return;
+  }
+  // Queries complete in order, so the last one stands for them all
+  GLint available = 0;
+  glGetQueryObjectiv(frame.scopes[frame.count - 1].end, GL_QUERY_RESULT_AVAILABLE, &available);
+  if (!available) {
+    ++dropped;
+    return;
+  }
+  for (int i = 0; i < frame.count; ++i) {
+    const ScopeQueries & queries = frame.scopes[i];
+    GLuint64 start = 0, end = 0;
+    glGetQueryObjectui64v(queries.start, GL_QUERY_RESULT, &start);
+    glGetQueryObjectui64v(queries.end, GL_QUERY_RESULT, &end);
+    passes[queries.pass].total += end - start;
+  }
+  for (size_t i = 0; i < passes.size(); ++i) {
+    Pass & pass = passes[i];
+    if (pass.total) {
+      pass.samples.push_back((float)((double)pass.total / 1e6));
+      pass.total = 0;
+      pass.fresh = true;
+    }
+  }
+}
+
+void GpuTimer::beginFrame() {
+  if (!initialized) {
+    for (int i = 0; i < RING_FRAMES; ++i) {
+      glGenQueries(MAX_SCOPES * 2, slots[i].queries);
+    }
+    initialized = true;
+  }
+
+  slot = (slot + 1) % RING_FRAMES;
+  for (size_t i = 0; i < passes.size(); ++i) {
+    passes[i].fresh = false;
+  }
+  readSlot(slots[slot]);
+  slots[slot].count = 0;
+
+  ++frames;
+  if (0 == frames % STATS_FRAMES) {
+    updateStats();
+  }
+  if (0 == frames % LOG_FRAMES) {
+    SAY("GPU times, min / avg / p99 ms over %d frames (%d dropped):\n%s",
+      HISTORY, dropped, format(stats).c_str());
+    dropped = 0;
+  }
+}
+
+const std::vector<GpuTimer::Stats> & GpuTimer::getStats() {
+  return stats;
+}
+
+uint32_t GpuTimer::getStatsVersion() {
+  return statsVersion;
+}
+
+bool GpuTimer::getLatest(const char * name, float & millis) {
+  for (size_t i = 0; i < passes.size(); ++i) {
+    const Pass & pass = passes[i];
+    if (pass.name == name || !strcmp(pass.name, name)) {
+      if (!pass.fresh) {
+        return false;
+      }
+      millis = pass.samples.back();
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string GpuTimer::format(const std::vector<Stats> & stats) {
+  std::string result;
+  for (size_t i = 0; i < stats.size(); ++i) {
+    const Stats & pass = stats[i];
+    result += Platform::format("%-12s %6.3f %6.3f %6.3f\n",
+      pass.name.c_str(), pass.min, pass.avg, pass.p99);
+  }
+  return result;
+}
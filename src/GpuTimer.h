@@ -0,0 +1,52 @@
+#pragma once
+
+// GPU timing for render passes, with GL_TIMESTAMP queries.  Each frame's
+// queries come from one slot of a ring, and are read back RING_FRAMES
+// frames later, by which time the GPU has normally finished with them, so
+// reading never stalls.  Timestamps rather than GL_TIME_ELAPSED, because
+// elapsed queries can't nest, and the passes do.
+//
+// A pass timed more than once in a frame, like the skybox drawn for each
+// eye, gets the total as that frame's sample.
+class GpuTimer {
+  GpuTimer() {}
+
+public:
+  static const int RING_FRAMES = 4;
+  static const int MAX_SCOPES = 64;
+  // Samples kept per pass
+  static const int HISTORY = 600;
+  // How often the statistics are recomputed, and logged
+  static const int STATS_FRAMES = 75;
+  static const int LOG_FRAMES = 750;
+
+  struct Stats {
+    std::string name;
+    float min{ 0 };
+    float avg{ 0 };
+    float p99{ 0 };
+  };
+
+  // Times the GPU work submitted between construction and destruction.
+  // The name should be a literal, or otherwise outlive the timer.
+  class Scope {
+    int scope;
+  public:
+    Scope(const char * name);
+    ~Scope();
+  };
+
+  // Call once per frame, before anything is timed.  Reads back the slot
+  // about to be reused.
+  static void beginFrame();
+  // In milliseconds, over the last HISTORY samples of each pass
+  static const std::vector<Stats> & getStats();
+  // Bumped whenever getStats changes
+  static uint32_t getStatsVersion();
+  // The newest sample of a pass, in milliseconds.  Returns false unless
+  // one was read back by this frame's beginFrame, so each sample is seen
+  // once.
+  static bool getLatest(const char * name, float & millis);
+  // One line per pass, for logs and overlays
+  static std::string format(const std::vector<Stats> & stats);
+};
@@ -204,4 +204,9 @@ bool Gui::handleSdlEvent(const SDL_Event & event, const vec2 & windowScaleFactor
     }
     return true;
   }
+  return false;
+}
+
+bool Gui::isDirty() {
+  return System::getSingleton().getDefaultGUIContext().isDirty();
 }
\ No newline at end of file
@@ -5,5 +5,8 @@ class Gui {
 public:
   static void init(const uvec2 & size);
   static bool handleSdlEvent(const SDL_Event & event, const vec2 & windowScaleFactor);
+  // True when CEGUI has invalidated the default context since it was last
+  // rendered
+  static bool isDirty();
 
 };
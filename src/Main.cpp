@@ -20,22 +20,9 @@ using namespace oglplus;
 using namespace std;
 using namespace CEGUI;
 
-Resource PIECE_RESOURCES[] = {
-  Resource::MESHES_CHESS_PAWN_CTM,
-  Resource::MESHES_CHESS_ROOK_CTM,
-  Resource::MESHES_CHESS_KNIGHT_CTM,
-  Resource::MESHES_CHESS_BISHOP_CTM,
-  Resource::MESHES_CHESS_QUEEN_CTM,
-  Resource::MESHES_CHESS_KING_CTM,
-};
-
 static uvec2 UI_SIZE(640, 480);
-
-static Geometry & getPieceGeometry(Chess::Piece piece) {
-  int pieceShape = (piece - 1) & 0x0F;
-  Resource res = PIECE_RESOURCES[pieceShape];
-  return GlUtils::getGeometry(res);
-}
+// How many of the listed games the tournament wall observes
+static const int WALL_GAMES = 64;
 
 class TaskQueue {
   boost::mutex m;
@@ -49,20 +36,30 @@ public:
     });
   }
 
-  void drain(long maxTimeMs = 0) {
+  // Returns true if any tasks ran.  Other threads may keep adding while
+  // this drains, so the queue is only looked at under the lock.
+  bool drain(long maxTimeMs = 0) {
     long start = Platform::elapsedMillis();
-    while (!q.empty()) {
+    bool ran = false;
+    while (true) {
       boost::function<void()> f;
       withScopedLock(m, [&](const boost::mutex::scoped_lock &){
-        f = q.front();
-        q.pop();
+        if (!q.empty()) {
+          f = q.front();
+          q.pop();
+        }
       });
+      if (!f) {
+        break;
+      }
+      ran = true;
       f();
       long now = Platform::elapsedMillis();
       if (maxTimeMs && ((now - start) > maxTimeMs)) {
         break;
       }
     }
+    return ran;
   }
 };
 
@@ -103,27 +100,73 @@ public:
 };
 
 
+// Everything the simulation thread hands the render thread each tick.
+// Copied whole, so the renderer never sees a half applied update.
+struct SceneSnapshot {
+  // Bumped whenever anything drawn changes
+  uint32_t version{ 0 };
+  mat4 player;
+  bool wallMode{ false };
+  Chess::Board board;
+  Fics::GameClock clock;
+  std::vector<Chess::Board> wallBoards;
+};
+
 class VirtualChess : public RiftApp {
   bool quit{ false };
-  // Task queue
 
   // GL rendering
-  mat4 player{ glm::inverse(glm::lookAt(vec3(0, 0.25, 0.35), vec3(0, 0.25, 0), vec3(0, 1, 0))) };
   Lights lights;
 
   // FICS state and interaction
   Fics::ClientPtr ficsClient;
+  // The list shown in the UI, owned by the main thread
   Fics::GameList games;
+
+  // Simulation state.  Only touched by the simulation thread, through
+  // simulate() and the tasks in simQueue.
+  mat4 player{ glm::inverse(glm::lookAt(vec3(0, 0.25, 0.35), vec3(0, 0.25, 0), vec3(0, 1, 0))) };
   Chess::Board board;
-  OffscreenFrame ui{ UI_SIZE };
+  Fics::GameClock clock;
+  Fics::GameList listedGames;
+  std::vector<Chess::Board> wallBoards;
+  // Maps observed game ids to their wall position
+  std::map<int, int> wallGames;
+  bool wallMode{ false };
   int activeGame{ -1 };
   bool loggedIn{ false };
+  uint32_t sceneVersion{ 0 };
+  TaskQueue simQueue;
+  boost::thread simThread;
+  std::atomic<bool> simRunning{ false };
+
+  // Written by the simulation thread, read just before each frame is drawn
+  TripleBuffer<SceneSnapshot> snapshots;
+  // The snapshot being drawn.  Render thread only.
+  const SceneSnapshot * scene{ nullptr };
+  // What was drawn, to tell when the scene changes
+  uint32_t drawnVersion{ 0 };
+  uint32_t resourceGeneration{ 0 };
+  PieceRenderer pieces;
+  BoardWall wall;
+  OffscreenFrame ui{ UI_SIZE };
+  // The procedural sky is drawn from a cubemap unless toggled off with
+  // F12, when it's evaluated per pixel in each eye for comparison
+  SkyboxCache skybox{ Resource::SHADERS_MOVINGTHROUGHSPEHERESPACE_FS };
+  bool cachedSkybox{ true };
+  // CEGUI work for the main thread
   TaskQueue taskQueue;
 
   // UI rendering
   Geometry uiGeometry;
 
   FrameWindow * rootWindow;
+  // GpuTimer statistics over the rest of the UI, toggled with F10
+  Window * gpuTimesWindow;
+  uint32_t gpuTimesVersion{ 0 };
+  // Both players' times for the active game
+  Window * clockWindow;
+  std::string clockText;
 
 
 public:
@@ -135,6 +178,23 @@ public:
     // Set the callback for FICS events   
     ficsClient->setEventHandler(boost::bind(&VirtualChess::onFicsEvent, this, _1));
 
+    // Between moves the scene is static, so most frames can be reprojected
+    frameReuse = true;
+
+    // Shaders, meshes and textures reload when their files change
+    ResourceWatcher::start();
+
+    // Decode the scene's assets in the background while the UI loads
+    AssetLoader loader;
+    loader.addSharedMeshes();
+    loader.addProgram(Resource::SHADERS_COLORED_VS, Resource::SHADERS_COLORED_FS);
+    loader.addProgram(Resource::SHADERS_COLOREDINSTANCED_VS, Resource::SHADERS_COLORED_FS);
+    loader.addProgram(Resource::SHADERS_LITCOLOREDINSTANCED_VS, Resource::SHADERS_LITCOLORED_FS);
+    loader.addProgram(Resource::SHADERS_TEXTURED_VS, Resource::SHADERS_TEXTURED_FS);
+    loader.addProgram(Resource::SHADERS_CUBEMAP_VS, Resource::SHADERS_MOVINGTHROUGHSPEHERESPACE_FS);
+    loader.addProgram(Resource::SHADERS_CUBEMAP_VS, Resource::SHADERS_CUBEMAP_FS);
+    loader.addProgram(Resource::SHADERS_MULTIRESRESOLVE_VS, Resource::SHADERS_MULTIRESRESOLVE_FS);
+
     // Load the rocket UI
     {
       Gui::init(UI_SIZE);
@@ -196,19 +256,98 @@ public:
           const MouseEventArgs & me = (const MouseEventArgs &)e;
           auto selMode = mcl->getSelectionMode();
           ListboxItem * li = mcl->getFirstSelectedItem();
-          const Fics::GameSummary & summary = games.at(li->getID());
-          if (-1 != activeGame) {
-            ficsClient->unobserveGame(activeGame);
-          }
-          activeGame = summary.id;
-          ficsClient->observeGame(activeGame);
+          int id = games.at(li->getID()).id;
+          simQueue.add([=]{
+            if (-1 != activeGame) {
+              ficsClient->unobserveGame(activeGame);
+            }
+            activeGame = id;
+            ficsClient->observeGame(activeGame);
+          });
           //ficsClient->listGames();
           return false;
         });
 
       }
+
+      {
+        gpuTimesWindow = wmgr.createWindow("TaharezLook/StaticText", "GpuTimes");
+        gpuTimesWindow->setPosition(UVector2(cegui_reldim(0.02f), cegui_reldim(0.02f)));
+        gpuTimesWindow->setSize(USize(cegui_reldim(0.5f), cegui_reldim(0.35f)));
+        gpuTimesWindow->setAlwaysOnTop(true);
+        gpuTimesWindow->hide();
+        rootWindow->addChild(gpuTimesWindow);
+      }
+
+      {
+        clockWindow = wmgr.createWindow("TaharezLook/StaticText", "Clock");
+        clockWindow->setPosition(UVector2(cegui_reldim(0.6f), cegui_reldim(0.02f)));
+        clockWindow->setSize(USize(cegui_reldim(0.38f), cegui_reldim(0.08f)));
+        clockWindow->setAlwaysOnTop(true);
+        clockWindow->hide();
+        rootWindow->addChild(clockWindow);
+      }
       showLoginUi();
     }
+
+    int64_t loadStart = Platform::elapsedNanos();
+    loader.finish([](int loaded, int total) {
+      SAY("Loaded %d of %d assets", loaded, total);
+    });
+    SAY("Waited %.1f ms for assets", (double)(Platform::elapsedNanos() - loadStart) / 1e6);
+
+    // So the first frame has a scene to draw
+    publishScene();
+    simRunning = true;
+    simThread = boost::thread([&] {
+      Profiler::setThreadName("Simulation");
+      simulate();
+    });
+  }
+
+  virtual ~VirtualChess() {
+    simRunning = false;
+    simThread.join();
+    ResourceWatcher::stop();
+  }
+
+  // Runs FICS game state, input and the camera at a fixed rate, off the
+  // render thread, publishing a snapshot of the scene after every tick
+  void simulate() {
+    // The camera controls move a fixed step per tick, tuned at 75 Hz
+    static const int64_t TICK_NANOS = 1000000000 / 75;
+    int64_t nextTick = Platform::elapsedNanos();
+    while (simRunning) {
+      {
+        Profiler::Zone zone("simulate");
+        simQueue.drain();
+        mat4 lastPlayer = player;
+        CameraControl::instance().applyInteraction(player);
+        if (lastPlayer != player) {
+          ++sceneVersion;
+        }
+        publishScene();
+      }
+      nextTick += TICK_NANOS;
+      int64_t now = Platform::elapsedNanos();
+      if (nextTick > now) {
+        Platform::sleepMillis((int)((nextTick - now) / 1000000));
+      } else {
+        // Fell behind, so don't try to catch up with a burst of ticks
+        nextTick = now;
+      }
+    }
+  }
+
+  void publishScene() {
+    SceneSnapshot & snapshot = snapshots.writeBuffer();
+    snapshot.version = sceneVersion;
+    snapshot.player = player;
+    snapshot.wallMode = wallMode;
+    snapshot.board = board;
+    snapshot.clock = clock;
+    snapshot.wallBoards = wallBoards;
+    snapshots.publish();
   }
 
   static void readLogin(std::string & username, std::string & password) {
@@ -218,9 +357,13 @@ public:
     prefs >> password;
   }
 
+  // Except the GPU times and the clock, which have their own toggles
   void hideAll() {
     for (int i = 0; i < rootWindow->getChildCount(); ++i) {
-      rootWindow->getChildAtIdx(i)->hide();
+      Window * child = rootWindow->getChildAtIdx(i);
+      if (child != gpuTimesWindow && child != clockWindow) {
+        child->hide();
+      }
     }
   }
 
@@ -297,30 +440,45 @@ public:
     switch (event.type) {
 
       case Fics::EventType::NETWORK: {
-        loggedIn = true;
+        simQueue.add([&]{
+          loggedIn = true;
+        });
         ficsClient->listGames();
-        showGameUi();
+        taskQueue.add([&]{
+          showGameUi();
+        });
         reloadDocument();
       } return;
 
       case Fics::EventType::GAME_LIST: {
-        games = *event.gameList.list;
+        Fics::GameList list = *event.gameList.list;
+        // Queued ahead of the reload, so the rows are filled from it
+        taskQueue.add([=]{
+          games = list;
+        });
         reloadDocument();
+        simQueue.add([=]{
+          listedGames = list;
+          if (wallMode) {
+            observeWallGames();
+          }
+        });
       } return;
 
       case Fics::EventType::GAME_STATE: {
         auto gameState = *event.gameState.state;
-        if (gameState.id == activeGame) {
-          board = gameState.board;
-        } else {
-          SAY("Dropping game state event from inactive game %d (active game is %d)", gameState.id, activeGame);
-        }
+        int lag = ficsClient->estimatedLagMillis();
+        simQueue.add([=]{
+          applyGameState(gameState, lag);
+        });
       } return;
 
       case Fics::EventType::CHAT: {
         string message(event.chat.message);
-        Listbox * mle = static_cast<Listbox*>(rootWindow->getChild("Tabs/Chat/Lines"));
-        mle->addItem(new ListboxTextItem(message));
+        taskQueue.add([=]{
+          Listbox * mle = static_cast<Listbox*>(rootWindow->getChild("Tabs/Chat/Lines"));
+          mle->addItem(new ListboxTextItem(message));
+        });
       } return;
     }
     SAY("Unhandled FICS event");
@@ -330,15 +488,122 @@ public:
     return quit;
   }
 
+  // Simulation thread only
+  void applyGameState(const Fics::GameState & gameState, int lag) {
+    bool playing = Fics::PLAYING_MY_MOVE == gameState.relation ||
+      Fics::PLAYING_OPPONENT_MOVE == gameState.relation;
+    if (playing && gameState.id != activeGame) {
+      activeGame = gameState.id;
+    }
+    if (wallMode) {
+      auto itr = wallGames.find(gameState.id);
+      if (itr != wallGames.end()) {
+        wallBoards[itr->second] = gameState.board;
+        ++sceneVersion;
+      }
+    }
+    if (gameState.id == activeGame) {
+      board = gameState.board;
+      clock.update(gameState, lag);
+      ++sceneVersion;
+    } else if (!wallMode) {
+      SAY("Dropping game state event from inactive game %d (active game is %d)", gameState.id, activeGame);
+    }
+  }
+
+  // Observes the first WALL_GAMES listed games, dropping any wall games
+  // that are no longer listed.  Simulation thread only.
+  void observeWallGames() {
+    int count = std::min<int>(listedGames.size(), WALL_GAMES);
+    std::map<int, int> newWallGames;
+    for (int i = 0; i < count; ++i) {
+      newWallGames[listedGames[i].id] = i;
+    }
+    for (auto & game : wallGames) {
+      if (!newWallGames.count(game.first)) {
+        ficsClient->unobserveGame(game.first);
+      }
+    }
+    for (auto & game : newWallGames) {
+      if (!wallGames.count(game.first) && game.first != activeGame) {
+        ficsClient->observeGame(game.first);
+      }
+    }
+    wallGames.swap(newWallGames);
+    wallBoards.resize(count);
+    ++sceneVersion;
+  }
+
+  void clearWallGames() {
+    for (auto & game : wallGames) {
+      if (game.first != activeGame) {
+        ficsClient->unobserveGame(game.first);
+      }
+    }
+    wallGames.clear();
+    wallBoards.clear();
+  }
+
+  void toggleWallMode() {
+    wallMode = !wallMode;
+    ++sceneVersion;
+    if (!loggedIn) {
+      return;
+    }
+    if (wallMode) {
+      observeWallGames();
+    } else {
+      clearWallGames();
+    }
+  }
+
 #define MAX_MILLIS 1
 
   bool handleSdlEvent(const SDL_Event & event) {
     switch (event.type) {
       case SDL_KEYDOWN: {
         switch (event.key.keysym.sym) {
+          case SDLK_F1: {
+            toggleMultires();
+          } return true;
+
+          case SDLK_F3: {
+            simQueue.add([&]{
+              toggleWallMode();
+            });
+          } return true;
+
+          case SDLK_F8: {
+            toggleStereoMode();
+          } return true;
+
+          case SDLK_F9: {
+            Culling::enabled = !Culling::enabled;
+            SAY("Culling %s", Culling::enabled ? "enabled" : "disabled");
+          } return true;
+
+          case SDLK_F11: {
+            Profiler::dump(Platform::getCachePath("Traces") +
+              Platform::format("trace-%d.json", (int)time(nullptr)));
+          } return true;
+
+          case SDLK_F10: {
+            gpuTimesWindow->setVisible(!gpuTimesWindow->isVisible());
+            gpuTimesVersion = 0;
+          } return true;
+
+          case SDLK_F12: {
+            cachedSkybox = !cachedSkybox;
+            SAY("Skybox %s", cachedSkybox ? "cached in a cubemap" : "procedural");
+          } return true;
+
           case SDLK_F6: {
             ovrHmd_RecenterPose(hmd);
           } return true;
+
+          case SDLK_F7: {
+            GlUtils::reportResourceUse();
+          } return true;
     
           case SDLK_F5: {
             static bool lowPersistence = false;
@@ -378,98 +643,158 @@ public:
     return false;
   }
 
+  static std::string formatClock(const Fics::GameClock & clock, int side) {
+    int seconds = clock.remainingMillis(side) / 1000;
+    return Platform::format("%s%s %d:%02d",
+      clock.isRunning(side) ? "> " : "  ",
+      Chess::Side::WHITE == side ? "White" : "Black",
+      seconds / 60, seconds % 60);
+  }
+
+  // Counts the clocks down every frame from the last drawn snapshot.  The
+  // text only changes once a second, so that's how often it costs a UI
+  // redraw.  Returns true if it changed.
+  bool updateClockWindow() {
+    if (!scene) {
+      return false;
+    }
+    std::string text;
+    if (scene->clock.isActive()) {
+      text = formatClock(scene->clock, Chess::Side::WHITE) + "\n" +
+        formatClock(scene->clock, Chess::Side::BLACK);
+    }
+    if (text == clockText) {
+      return false;
+    }
+    clockText = text;
+    clockWindow->setText(clockText);
+    clockWindow->setVisible(!clockText.empty());
+    return true;
+  }
+
   void updateState() {
     ovrHSWDisplayState hsw;
     ovrHmd_GetHSWDisplayState(hmd, &hsw);
     if (hsw.Displayed) {
       ovrHmd_DismissHSWDisplay(hmd);
     }
-    // Process any background tasks queued up
-    taskQueue.drain(MAX_MILLIS);
+    // Process any background tasks queued up.  These may change widgets,
+    // so the UI is redrawn whenever any ran.
+    bool uiDirty;
+    {
+      Profiler::Zone zone("taskQueue.drain");
+      uiDirty = taskQueue.drain(MAX_MILLIS);
+    }
 
     static const vec2 windowScaleFactor = vec2(UI_SIZE) / vec2(windowSize);
     SDL_Event event;
     while (SDL_PollEvent(&event)) {
       if (handleSdlEvent(event)) {
+        // The function keys change how things are drawn
+        invalidateScene();
         continue;
       }
       if (Gui::handleSdlEvent(event, windowScaleFactor)) {
+        uiDirty = true;
         continue;
       }
 
-      if (CameraControl::instance().onEvent(event)) {
-        continue;
-      }
+      // The camera moves on the simulation thread
+      simQueue.add([=]{
+        CameraControl::instance().onEvent(event);
+      });
     }
 
-    ui.withFbo([]{
-      System::getSingleton().renderAllGUIContexts();
-      glDisable(GL_SCISSOR_TEST);
-    });
-
-    CameraControl::instance().applyInteraction(player);
-    Stacks::modelview().top() = glm::inverse(player);
-  }
+    if (gpuTimesWindow->isVisible() && gpuTimesVersion != GpuTimer::getStatsVersion()) {
+      gpuTimesVersion = GpuTimer::getStatsVersion();
+      gpuTimesWindow->setText("GPU ms: min / avg / p99\n" +
+        GpuTimer::format(GpuTimer::getStats()) +
+        Platform::format("Eye pixels shaded: %.0f%%", getShadedFraction() * 100.0f));
+      uiDirty = true;
+    }
 
-  void renderBoard() {
-    Program & prog = GlUtils::getProgram(
-        Resource::SHADERS_LIT_VS, 
-        Resource::SHADERS_LITCOLORED_FS);
-    prog.Use();
-    SET_PROJECTION(prog);
-    SET_MODELVIEW(prog);
-    SET_LIGHTS(prog, lights);
+    if (updateClockWindow()) {
+      uiDirty = true;
+    }
 
-    MatrixStack & mv = Stacks::modelview();
-    mv.withPush([&]{
-      mv.scale(GlUtils::CHESS_SCALE);
-      mv.translate(vec3(-3.5, 0, -3.5));
-      Chess::forEachSquare([&](int row, int col){
-        mv.withPush([&] {
-          Chess::Piece piece = board.position[row][col];
-          if (!piece) {
-            return;
-          }
-          mv.translate(vec3(col, 0, 7 - row));
+    // The UI texture keeps its contents between frames, so it only needs
+    // to be redrawn when something in it might have changed
+    if (uiDirty || Gui::isDirty()) {
+      invalidateScene();
+      ui.withFbo([]{
+        GpuTimer::Scope timer("UI");
+        System::getSingleton().renderAllGUIContexts();
+        glDisable(GL_SCISSOR_TEST);
+      });
+    }
 
-          vec3 color = Colors::white;
-          if (piece & 0x10) {
-            color = Colors::dimGrey;
-          } else {
-            mv.rotate(PI, GlUtils::Y_AXIS);
-          }
+    // The procedural sky animates every frame, the cached one whenever
+    // a new cubemap is swapped in
+    if (!cachedSkybox || skybox.update()) {
+      invalidateScene();
+    }
+    // Hot reloaded shaders, meshes or textures
+    if (resourceGeneration != ResourceWatcher::getAnyGeneration()) {
+      resourceGeneration = ResourceWatcher::getAnyGeneration();
+      invalidateScene();
+    }
 
-          Uniform<vec4>(prog, Layout::Uniform::Color).Set(vec4(color, 1));
-          mv.scale(1.6f);
-          SET_MODELVIEW(prog);
-          Geometry & pieceGeometry = getPieceGeometry(piece);
-          pieceGeometry.bind();
-          pieceGeometry.draw();
-          NoVertexArray().Bind();
-        });
-      });
-    });
-    NoProgram().Use();
-    NoVertexArray().Bind();
+    // Taken as late as possible, so the frame shows the newest simulation
+    // tick
+    scene = &snapshots.consume();
+    if (drawnVersion != scene->version) {
+      drawnVersion = scene->version;
+      invalidateScene();
+    }
+    pieces.setBoard(scene->board);
+    wall.setBoardCount(scene->wallBoards.size());
+    for (size_t i = 0; i < scene->wallBoards.size(); ++i) {
+      wall.setBoard(i, scene->wallBoards[i]);
+    }
+    Stacks::modelview().top() = glm::inverse(scene->player);
+    // Levels are judged once per frame against the whole eye, not whatever
+    // viewport the UI or sky passes left behind, or a multires region
+    const PerEyeArgs & eyeArgs = eyesArgs[ovrEye_Left];
+    float pixelScale = PieceRenderer::getPixelScale(eyeArgs.projection, eyeArgs.viewportSize.y);
+    if (scene->wallMode) {
+      wall.update(pixelScale);
+    } else {
+      pieces.update(pixelScale);
+    }
+  }
 
-    Render::renderGeometry(
-      GlUtils::getProgram(Resource::SHADERS_COLORED_VS, Resource::SHADERS_COLORED_FS),
-      GlUtils::getChessBoardGeometry()
-    );
+  void renderBoard() {
+    GpuTimer::Scope timer("Board");
+    if (scene->wallMode) {
+      wall.render();
+      return;
+    }
+    pieces.render();
   }
   void drawScene() {
     gl.Clear().ColorBuffer().DepthBuffer();
+    Uniforms::setLights(lights);
     int viewport[4];
     glGetIntegerv(GL_VIEWPORT, viewport);
-    Render::renderProceduralSkybox(Resource::SHADERS_MOVINGTHROUGHSPEHERESPACE_FS);
+    if (cachedSkybox) {
+      skybox.render();
+    } else {
+      static const ProgramHandle skyboxProgram = GlUtils::getProgramHandle(
+        Resource::SHADERS_CUBEMAP_VS, Resource::SHADERS_MOVINGTHROUGHSPEHERESPACE_FS);
+      Render::renderProceduralSkybox(skyboxProgram);
+    }
 //    Render::renderSkybox(Resource::IMAGES_SKY_CITY_XNEG_PNG);
-    return;
     MatrixStack & mv = Stacks::modelview();
+    static const ProgramHandle texturedProgram = GlUtils::getProgramHandle(
+      Resource::SHADERS_TEXTURED_VS, Resource::SHADERS_TEXTURED_FS);
     mv.withPush([&]{
       mv.translate(vec3(0, 0.35, -0.35f));
+      if (!Culling::isVisible(uiGeometry.bounds, mv.top())) {
+        return;
+      }
       ui.tex.Bind(oglplus::Texture::Target::_2D);
       Render::renderGeometry(
-        GlUtils::getProgram(Resource::SHADERS_TEXTURED_VS, Resource::SHADERS_TEXTURED_FS),
+        GlUtils::getProgram(texturedProgram),
         uiGeometry
       );
     });
@@ -0,0 +1,116 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+int MeshBuffer::add(const Mesh & mesh) {
+  addLayout(VertexLayout(mesh));
+  PendingMesh entry;
+  entry.mesh = mesh;
+  pending.push_back(entry);
+  return addRange(mesh.positions.size(), mesh.indices.size(), Bounds::of(mesh));
+}
+
+int MeshBuffer::add(Resource resource, int lod) {
+  // Usually already in the final layout.  If this mesh widens the layout,
+  // prepare fetches it again.
+  PendingMesh entry;
+  entry.resource = resource;
+  entry.lod = lod;
+  entry.cached = MeshCache::load(resource, &layout, lod);
+  addLayout(entry.cached->sourceLayout());
+  pending.push_back(entry);
+  const MeshCacheHeader & header = entry.cached->header();
+  return addRange(header.vertexCount, header.indexCount, entry.cached->bounds());
+}
+
+void MeshBuffer::addLayout(const VertexLayout & meshLayout) {
+  layout.normals |= meshLayout.normals;
+  layout.colors |= meshLayout.colors;
+  layout.texCoords |= meshLayout.texCoords;
+}
+
+int MeshBuffer::addRange(size_t vertices, size_t indices, const Bounds & bounds) {
+  MeshRange range;
+  range.baseVertex = vertexCount;
+  range.firstIndex = indexCount;
+  range.count = indices;
+  range.bounds = bounds;
+  ranges.push_back(range);
+
+  vertexCount += vertices;
+  indexCount += indices;
+  maxMeshVertices = std::max(maxMeshVertices, vertices);
+  return ranges.size() - 1;
+}
+
+template <typename T>
+static void appendIndices(const uint8_t * data, size_t count, std::vector<GLuint> & indices) {
+  const T * typed = (const T *)data;
+  indices.insert(indices.end(), typed, typed + count);
+}
+
+void MeshBuffer::upload() {
+  vertexBytes = (size_t)vertexCount * layout.stride();
+  uint32_t layoutFlags = MeshCache::layoutFlags(layout);
+  vao.Bind();
+  vertexBuffer.Bind(Buffer::Target::Array);
+  glBufferData(GL_ARRAY_BUFFER, vertexBytes, nullptr, GL_STATIC_DRAW);
+  {
+    std::vector<GLuint> indices;
+    indices.reserve(indexCount);
+    GLintptr offset = 0;
+    std::vector<uint8_t> vertices;
+    for (size_t i = 0; i < pending.size(); ++i) {
+      PendingMesh & entry = pending[i];
+      if (NO_RESOURCE == entry.resource) {
+        vertices.clear();
+        layout.interleave(entry.mesh, vertices);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, vertices.size(), vertices.data());
+        offset += vertices.size();
+        indices.insert(indices.end(), entry.mesh.indices.begin(), entry.mesh.indices.end());
+        continue;
+      }
+
+      if (entry.cached->header().layout != layoutFlags) {
+        entry.cached = MeshCache::load(entry.resource, &layout, entry.lod);
+      }
+      const MeshCacheHeader & header = entry.cached->header();
+      glBufferSubData(GL_ARRAY_BUFFER, offset, header.vertexBytes, entry.cached->vertices());
+      offset += header.vertexBytes;
+      if (GL_UNSIGNED_SHORT == header.indexType) {
+        appendIndices<GLushort>(entry.cached->indices(), header.indexCount, indices);
+      } else {
+        appendIndices<GLuint>(entry.cached->indices(), header.indexCount, indices);
+      }
+    }
+    indexType = Geometry::uploadIndices(indexBuffer, indices, maxMeshVertices);
+  }
+
+  indexBuffer.Bind(Buffer::Target::ElementArray);
+  layout.setupAttributes();
+  NoVertexArray().Bind();
+  NoBuffer().Bind(Buffer::Target::Array);
+  NoBuffer().Bind(Buffer::Target::ElementArray);
+
+  std::vector<PendingMesh>().swap(pending);
+  ++version;
+}
+
+void MeshBuffer::clear() {
+  layout = initialLayout;
+  pending.clear();
+  ranges.clear();
+  vertexCount = 0;
+  indexCount = 0;
+  maxMeshVertices = 0;
+}
+
+void MeshBuffer::enableInstancing(bool instanceColor) {
+  if (instanced) {
+    return;
+  }
+  instanced = true;
+  vao.Bind();
+  VertexLayout::setupInstanceAttributes(instanceColor);
+  NoVertexArray().Bind();
+}
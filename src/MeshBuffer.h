@@ -0,0 +1,108 @@
+#pragma once
+
+// The location of one mesh inside a MeshBuffer, suitable for a
+// glDrawElementsBaseVertex or DrawElementsIndirectCommand
+struct MeshRange {
+  GLint   baseVertex{ 0 };
+  GLuint  firstIndex{ 0 };
+  GLsizei count{ 0 };
+  Bounds  bounds;
+};
+
+// Matches the layout glMultiDrawElementsIndirect expects
+struct DrawElementsIndirectCommand {
+  GLuint count;
+  GLuint instanceCount;
+  GLuint firstIndex;
+  GLint  baseVertex;
+  GLuint baseInstance;
+};
+
+// Several meshes sharing a single vertex buffer, index buffer and VAO, so
+// they can be drawn with base vertex and multi-draw calls without
+// rebinding.  The vertex layout is the union of the meshes' attributes,
+// with defaults filled in where a mesh lacks one.
+class MeshBuffer {
+  // Either a mesh, or a resource fetched from the MeshCache
+  struct PendingMesh {
+    Mesh          mesh;
+    Resource      resource{ NO_RESOURCE };
+    int           lod{ 0 };
+    CachedMeshPtr cached;
+  };
+
+  VertexLayout          initialLayout;
+  VertexLayout          layout;
+  std::vector<PendingMesh> pending;
+  GLint                 vertexCount{ 0 };
+  GLuint                indexCount{ 0 };
+  // Indices are relative to each mesh's base vertex, so this is the
+  // largest single mesh rather than the whole buffer
+  size_t                maxMeshVertices{ 0 };
+
+  void addLayout(const VertexLayout & meshLayout);
+  int addRange(size_t vertices, size_t indices, const Bounds & bounds);
+
+public:
+  oglplus::Buffer       vertexBuffer;
+  oglplus::Buffer       indexBuffer;
+  oglplus::VertexArray  vao;
+  std::vector<MeshRange> ranges;
+  GLenum                elementType{ GL_TRIANGLES };
+  // Set by upload, GL_UNSIGNED_SHORT if every mesh is small enough
+  GLenum                indexType{ GL_UNSIGNED_INT };
+  bool                  instanced{ false };
+  // The size of the vertex buffer once uploaded
+  size_t                vertexBytes{ 0 };
+  // Bumped by every upload, so anything holding ranges or commands built
+  // from them can tell when they're stale
+  uint32_t              version{ 0 };
+
+  MeshBuffer() {
+  }
+
+  // Starts from a known layout.  Cached meshes whose attributes fit in it
+  // are loaded in their final form by add, and never re-fetched.
+  explicit MeshBuffer(const VertexLayout & layout) : initialLayout(layout), layout(layout) {
+  }
+
+  // Returns the index of the new mesh's range
+  int add(const Mesh & mesh);
+  // Adds a CTM mesh through the MeshCache, at a MeshCache level of detail
+  int add(Resource resource, int lod = 0);
+  // Pushes the accumulated meshes to the GPU and releases the CPU copies
+  void upload();
+  // Drops every range, so the meshes can be added and uploaded again.
+  // The buffers and VAO are reused.
+  void clear();
+  void enableInstancing(bool instanceColor = true);
+
+  void bind() {
+    vao.Bind();
+  }
+
+  void draw(int mesh) {
+    drawInstanced(mesh, 1);
+  }
+
+  // Like Geometry, honours Geometry::viewCount
+  void drawInstanced(int mesh, int count, int baseInstance = 0) {
+    const MeshRange & range = ranges[mesh];
+    ++Geometry::drawCalls;
+    glDrawElementsInstancedBaseVertexBaseInstance(elementType, range.count, indexType,
+      (void*)(range.firstIndex * Geometry::indexSize(indexType)), count * Geometry::viewCount, range.baseVertex, baseInstance);
+  }
+
+  // The instance count is scaled by Geometry::viewCount, so commands
+  // stored across frames must be rebuilt when it changes
+  DrawElementsIndirectCommand getCommand(int mesh, GLuint instanceCount, GLuint baseInstance) const {
+    const MeshRange & range = ranges[mesh];
+    DrawElementsIndirectCommand command;
+    command.count = range.count;
+    command.instanceCount = instanceCount * Geometry::viewCount;
+    command.firstIndex = range.firstIndex;
+    command.baseVertex = range.baseVertex;
+    command.baseInstance = baseInstance;
+    return command;
+  }
+};
@@ -0,0 +1,188 @@
+#include "Common.h"
+
+const uint32_t MeshCache::MAGIC = 0x4D484356; // "VCHM"
+
+enum LayoutFlag {
+  NORMALS = 1 << 0,
+  COLORS = 1 << 1,
+  TEX_COORDS = 1 << 2,
+  PACKED = 1 << 3,
+};
+
+uint32_t MeshCache::layoutFlags(const VertexLayout & layout) {
+  return (layout.normals ? NORMALS : 0) |
+    (layout.colors ? COLORS : 0) |
+    (layout.texCoords ? TEX_COORDS : 0) |
+    (layout.packed ? PACKED : 0);
+}
+
+static VertexLayout fromFlags(uint32_t flags) {
+  VertexLayout result;
+  result.normals = 0 != (flags & NORMALS);
+  result.colors = 0 != (flags & COLORS);
+  result.texCoords = 0 != (flags & TEX_COORDS);
+  result.packed = 0 != (flags & PACKED);
+  return result;
+}
+
+VertexLayout CachedMesh::layout() const {
+  return fromFlags(header().layout);
+}
+
+VertexLayout CachedMesh::sourceLayout() const {
+  return fromFlags(header().sourceLayout);
+}
+
+Bounds CachedMesh::bounds() const {
+  Bounds result;
+  result.min = glm::make_vec3(header().boundsMin);
+  result.max = glm::make_vec3(header().boundsMax);
+  return result;
+}
+
+const std::string & MeshCache::getDirectory() {
+  static std::string directory;
+  static bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    directory = Platform::getCachePath("MeshCache");
+  }
+  return directory;
+}
+
+static std::string getCacheKey(Resource resource, const VertexLayout * layout, int lod) {
+  std::string name = Files::flatten(Platform::getResourcePath(resource));
+  std::string suffix = layout ?
+    Platform::format("%x", MeshCache::layoutFlags(*layout)) : "auto";
+  if (lod) {
+    suffix += Platform::format(".lod%d", lod);
+  }
+  return name + "." + suffix;
+}
+
+static std::string getCacheFile(const std::string & key) {
+  const std::string & directory = MeshCache::getDirectory();
+  if (directory.empty()) {
+    return directory;
+  }
+  return directory + key + ".bin";
+}
+
+// Entries that are still referenced somewhere
+static boost::mutex liveMutex;
+static std::map<std::string, std::weak_ptr<CachedMesh>> liveEntries;
+
+static uint64_t getSourceStamp(Resource resource) {
+  time_t modified = Platform::getResourceModified(resource);
+  if (modified) {
+    return (uint64_t)modified;
+  }
+  // Embedded resources have no modification time, so fall back to an
+  // FNV-1a hash, which is still far cheaper than decoding the mesh
+  std::vector<uint8_t> data = Platform::getResourceVector(resource);
+  return Platform::hash(data.data(), data.size());
+}
+
+static bool isValid(const MappedFile & file, uint64_t stamp, const VertexLayout * layout) {
+  if (!file.isValid() || file.size() < sizeof(MeshCacheHeader)) {
+    return false;
+  }
+  const MeshCacheHeader & header = *(const MeshCacheHeader *)file.data();
+  return MeshCache::MAGIC == header.magic &&
+    MeshCache::VERSION == header.version &&
+    stamp == header.sourceStamp &&
+    (!layout || MeshCache::layoutFlags(*layout) == header.layout) &&
+    file.size() == sizeof(MeshCacheHeader) + header.vertexBytes + header.indexBytes;
+}
+
+// Decodes and optimizes the CTM, producing the contents of a cache file
+static void buildEntry(Resource resource, uint64_t stamp,
+    const VertexLayout * requestedLayout, int lod, std::vector<uint8_t> & result) {
+  Mesh mesh;
+  GlUtils::loadCtmMesh(resource, mesh);
+  if (lod) {
+    MeshOptimizer::simplify(mesh, 1.0f / (1 << lod), getCacheKey(resource, requestedLayout, lod));
+  }
+  VertexLayout layout = requestedLayout ? *requestedLayout : VertexLayout(mesh);
+  std::vector<uint8_t> vertices;
+  layout.interleave(mesh, vertices);
+
+  MeshCacheHeader header = {};
+  header.magic = MeshCache::MAGIC;
+  header.version = MeshCache::VERSION;
+  header.sourceStamp = stamp;
+  header.layout = MeshCache::layoutFlags(layout);
+  header.sourceLayout = MeshCache::layoutFlags(VertexLayout(mesh));
+  header.vertexCount = mesh.positions.size();
+  header.indexCount = mesh.indices.size();
+  header.vertexBytes = vertices.size();
+  Bounds bounds = Bounds::of(mesh);
+  memcpy(header.boundsMin, &bounds.min, sizeof(header.boundsMin));
+  memcpy(header.boundsMax, &bounds.max, sizeof(header.boundsMax));
+
+  std::vector<GLushort> shortIndices;
+  const uint8_t * indexData = (const uint8_t *)mesh.indices.data();
+  if (mesh.positions.size() <= 0x10000) {
+    shortIndices.assign(mesh.indices.begin(), mesh.indices.end());
+    indexData = (const uint8_t *)shortIndices.data();
+    header.indexType = GL_UNSIGNED_SHORT;
+  } else {
+    header.indexType = GL_UNSIGNED_INT;
+  }
+  header.indexBytes = mesh.indices.size() * Geometry::indexSize(header.indexType);
+
+  result.resize(sizeof(MeshCacheHeader) + header.vertexBytes + header.indexBytes);
+  uint8_t * out = result.data();
+  memcpy(out, &header, sizeof(MeshCacheHeader));
+  out += sizeof(MeshCacheHeader);
+  memcpy(out, vertices.data(), vertices.size());
+  out += vertices.size();
+  memcpy(out, indexData, header.indexBytes);
+}
+
+CachedMeshPtr MeshCache::load(Resource resource, const VertexLayout * layout, int lod) {
+  int64_t start = Platform::elapsedNanos();
+  std::string path = Platform::getResourcePath(resource);
+  std::string key = getCacheKey(resource, layout, lod);
+  std::string filename = getCacheFile(key);
+  uint64_t stamp = getSourceStamp(resource);
+
+  {
+    CachedMeshPtr live;
+    withScopedLock(liveMutex, [&](const boost::mutex::scoped_lock &){
+      live = liveEntries[key].lock();
+    });
+    if (live && stamp == live->header().sourceStamp) {
+      return live;
+    }
+  }
+
+  CachedMeshPtr result(new CachedMesh());
+  bool hit = false;
+  if (!filename.empty()) {
+    result->mapping.reset(new MappedFile(filename));
+    hit = isValid(*result->mapping, stamp, layout);
+  }
+
+  if (!hit) {
+    // Release the stale mapping so the file can be replaced
+    result->mapping.reset();
+    std::vector<uint8_t> data;
+    buildEntry(resource, stamp, layout, lod, data);
+    if (!filename.empty() && Files::replace(filename, data.data(), data.size())) {
+      result->mapping.reset(new MappedFile(filename));
+    }
+    if (!result->mapping || !isValid(*result->mapping, stamp, layout)) {
+      SAY_ERR("Unable to cache %s in %s", path.c_str(), filename.c_str());
+      result->mapping.reset();
+      result->memory.swap(data);
+    }
+  }
+
+  withScopedLock(liveMutex, [&](const boost::mutex::scoped_lock &){
+    liveEntries[key] = result;
+  });
+  SAY("%s: %s in %.2f ms", key.c_str(), hit ? "loaded from cache" : "rebuilt cache",
+    (double)(Platform::elapsedNanos() - start) / 1e6);
+  return result;
+}
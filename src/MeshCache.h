@@ -0,0 +1,80 @@
+#pragma once
+
+// The on disk format of a cached mesh.  The interleaved vertices follow
+// the header, and the indices follow the vertices, both ready to hand to
+// glBufferData.
+struct MeshCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  // The source modification time, or a hash of its contents when the
+  // platform can't supply one
+  uint64_t sourceStamp;
+  // VertexLayout flags, see MeshCache::layoutFlags.  The layout the data
+  // is stored in, and the attributes the source mesh actually has.
+  uint32_t layout;
+  uint32_t sourceLayout;
+  uint32_t indexType;
+  uint32_t vertexCount;
+  uint32_t indexCount;
+  // Pads vertexBytes to 8 bytes explicitly, so no uninitialized padding
+  // reaches the file.  Always zero.
+  uint32_t reserved;
+  uint64_t vertexBytes;
+  uint64_t indexBytes;
+  // The Bounds of the positions
+  float    boundsMin[3];
+  float    boundsMax[3];
+};
+
+// A loaded cache entry.  Normally a view into the mapped cache file, but
+// held in memory if the cache couldn't be written.
+class CachedMesh {
+  friend class MeshCache;
+  std::unique_ptr<MappedFile> mapping;
+  std::vector<uint8_t> memory;
+
+  const uint8_t * bytes() const {
+    return mapping ? mapping->data() : memory.data();
+  }
+
+public:
+  const MeshCacheHeader & header() const {
+    return *(const MeshCacheHeader *)bytes();
+  }
+  const uint8_t * vertices() const {
+    return bytes() + sizeof(MeshCacheHeader);
+  }
+  const uint8_t * indices() const {
+    return vertices() + header().vertexBytes;
+  }
+  VertexLayout layout() const;
+  VertexLayout sourceLayout() const;
+  Bounds bounds() const;
+};
+
+typedef std::shared_ptr<CachedMesh> CachedMeshPtr;
+
+// Preprocessed CTM meshes, so startup skips decompression, optimization
+// and interleaving.  Entries are keyed by resource, vertex layout and
+// level of detail, and rebuilt whenever the source changes or the format
+// version is bumped.
+//
+// load is safe to call from any thread once the directory is known.
+// Entries still in use are shared rather than mapped again.
+class MeshCache {
+  MeshCache() {}
+
+public:
+  static const uint32_t MAGIC;
+  // Bump whenever the optimizer, packing or this format changes
+  static const uint32_t VERSION = 3;
+
+  static uint32_t layoutFlags(const VertexLayout & layout);
+  // Where entries are stored, empty if there's nowhere writable.  Found on
+  // first use, which should be on the main thread.
+  static const std::string & getDirectory();
+
+  // Without a layout the mesh's own attributes are used.  Each level of
+  // detail above 0 is simplified to half the triangles of the one before.
+  static CachedMeshPtr load(Resource resource, const VertexLayout * layout = nullptr, int lod = 0);
+};
@@ -0,0 +1,510 @@
+#include "Common.h"
+
+template <typename T>
+static void remap(std::vector<T> & attribute, const std::vector<GLuint> & newToOld) {
+  if (attribute.empty()) {
+    return;
+  }
+  std::vector<T> result(newToOld.size());
+  for (size_t i = 0; i < newToOld.size(); ++i) {
+    result[i] = attribute[newToOld[i]];
+  }
+  attribute.swap(result);
+}
+
+template <typename T>
+static void appendKey(std::string & key, const std::vector<T> & attribute, size_t index) {
+  if (!attribute.empty()) {
+    key.append((const char *)&attribute[index], sizeof(T));
+  }
+}
+
+static void remapVertices(Mesh & mesh, const std::vector<GLuint> & newToOld) {
+  remap(mesh.positions, newToOld);
+  remap(mesh.normals, newToOld);
+  remap(mesh.colors, newToOld);
+  remap(mesh.texCoords, newToOld);
+}
+
+void MeshOptimizer::deduplicate(Mesh & mesh) {
+  std::unordered_map<std::string, GLuint> unique;
+  std::vector<GLuint> oldToNew(mesh.positions.size());
+  std::vector<GLuint> newToOld;
+  std::string key;
+  for (size_t i = 0; i < mesh.positions.size(); ++i) {
+    key.clear();
+    appendKey(key, mesh.positions, i);
+    appendKey(key, mesh.normals, i);
+    appendKey(key, mesh.colors, i);
+    appendKey(key, mesh.texCoords, i);
+    auto inserted = unique.insert(std::make_pair(key, (GLuint)newToOld.size()));
+    if (inserted.second) {
+      newToOld.push_back(i);
+    }
+    oldToNew[i] = inserted.first->second;
+  }
+
+  if (newToOld.size() == mesh.positions.size()) {
+    return;
+  }
+  for (size_t i = 0; i < mesh.indices.size(); ++i) {
+    mesh.indices[i] = oldToNew[mesh.indices[i]];
+  }
+  remapVertices(mesh, newToOld);
+}
+
+namespace Forsyth {
+  const float CACHE_DECAY_POWER = 1.5f;
+  const float LAST_TRI_SCORE = 0.75f;
+  const float VALENCE_BOOST_SCALE = 2.0f;
+  const float VALENCE_BOOST_POWER = 0.5f;
+
+  struct Vertex {
+    std::vector<int> triangles;
+    int remaining{ 0 };
+    int cachePosition{ -1 };
+    float score{ 0 };
+  };
+
+  float score(const Vertex & vertex) {
+    if (0 == vertex.remaining) {
+      return -1.0f;
+    }
+    float result = 0;
+    int position = vertex.cachePosition;
+    if (position >= 0) {
+      if (position < 3) {
+        // The vertices of the last triangle get a fixed score, so the
+        // next triangle doesn't simply reuse the same edge
+        result = LAST_TRI_SCORE;
+      } else {
+        float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+        result = pow(1.0f - (position - 3) * scaler, CACHE_DECAY_POWER);
+      }
+    }
+    // Favour vertices with few triangles left, to avoid leaving stragglers
+    result += VALENCE_BOOST_SCALE * pow((float)vertex.remaining, -VALENCE_BOOST_POWER);
+    return result;
+  }
+}
+
+void MeshOptimizer::optimizeVertexCache(Mesh & mesh) {
+  using namespace Forsyth;
+  int triangleCount = mesh.indices.size() / 3;
+  if (!triangleCount) {
+    return;
+  }
+
+  std::vector<Vertex> vertices(mesh.positions.size());
+  for (int t = 0; t < triangleCount; ++t) {
+    for (int i = 0; i < 3; ++i) {
+      Vertex & vertex = vertices[mesh.indices[t * 3 + i]];
+      vertex.triangles.push_back(t);
+      ++vertex.remaining;
+    }
+  }
+  for (size_t v = 0; v < vertices.size(); ++v) {
+    vertices[v].score = score(vertices[v]);
+  }
+
+  std::vector<float> triangleScores(triangleCount);
+  std::vector<bool> added(triangleCount, false);
+  for (int t = 0; t < triangleCount; ++t) {
+    for (int i = 0; i < 3; ++i) {
+      triangleScores[t] += vertices[mesh.indices[t * 3 + i]].score;
+    }
+  }
+
+  std::vector<GLuint> result;
+  result.reserve(mesh.indices.size());
+  // Holds up to 3 entries beyond the cache while it's being updated
+  std::vector<int> cache;
+  cache.reserve(CACHE_SIZE + 3);
+  int best = -1;
+  int scanStart = 0;
+
+  for (int emitted = 0; emitted < triangleCount; ++emitted) {
+    if (best < 0) {
+      // Nothing in the cache is useful, so take the best remaining triangle.
+      // Triangles before scanStart have all been added.
+      float bestScore = -1;
+      for (int t = scanStart; t < triangleCount; ++t) {
+        if (!added[t] && triangleScores[t] > bestScore) {
+          bestScore = triangleScores[t];
+          best = t;
+        }
+      }
+    }
+
+    int triangle = best;
+    added[triangle] = true;
+    while (scanStart < triangleCount && added[scanStart]) {
+      ++scanStart;
+    }
+
+    // Emit the triangle and move its vertices to the front of the cache
+    std::vector<int> newCache;
+    newCache.reserve(CACHE_SIZE + 3);
+    for (int i = 0; i < 3; ++i) {
+      int v = mesh.indices[triangle * 3 + i];
+      result.push_back(v);
+      newCache.push_back(v);
+      Vertex & vertex = vertices[v];
+      --vertex.remaining;
+      vertex.triangles.erase(std::find(vertex.triangles.begin(), vertex.triangles.end(), triangle));
+    }
+    for (size_t i = 0; i < cache.size(); ++i) {
+      int v = cache[i];
+      if (std::find(newCache.begin(), newCache.begin() + 3, v) == newCache.begin() + 3) {
+        newCache.push_back(v);
+      }
+    }
+    cache.swap(newCache);
+
+    // Rescore everything that was in the cache, including anything that
+    // just fell out of it
+    for (size_t i = 0; i < cache.size(); ++i) {
+      Vertex & vertex = vertices[cache[i]];
+      vertex.cachePosition = (i < CACHE_SIZE) ? (int)i : -1;
+      float newScore = score(vertex);
+      float delta = newScore - vertex.score;
+      vertex.score = newScore;
+      for (size_t j = 0; j < vertex.triangles.size(); ++j) {
+        triangleScores[vertex.triangles[j]] += delta;
+      }
+    }
+    if (cache.size() > CACHE_SIZE) {
+      cache.resize(CACHE_SIZE);
+    }
+
+    // The next triangle is the best one touching the cache
+    best = -1;
+    float bestScore = -1;
+    for (size_t i = 0; i < cache.size(); ++i) {
+      const Vertex & vertex = vertices[cache[i]];
+      for (size_t j = 0; j < vertex.triangles.size(); ++j) {
+        int t = vertex.triangles[j];
+        if (triangleScores[t] > bestScore) {
+          bestScore = triangleScores[t];
+          best = t;
+        }
+      }
+    }
+  }
+  mesh.indices.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(Mesh & mesh) {
+  static const GLuint UNUSED = ~0u;
+  std::vector<GLuint> oldToNew(mesh.positions.size(), UNUSED);
+  std::vector<GLuint> newToOld;
+  newToOld.reserve(mesh.positions.size());
+  for (size_t i = 0; i < mesh.indices.size(); ++i) {
+    GLuint & index = mesh.indices[i];
+    if (UNUSED == oldToNew[index]) {
+      oldToNew[index] = newToOld.size();
+      newToOld.push_back(index);
+    }
+    index = oldToNew[index];
+  }
+  remapVertices(mesh, newToOld);
+}
+
+float MeshOptimizer::acmr(const std::vector<GLuint> & indices) {
+  if (indices.size() < 3) {
+    return 0;
+  }
+  std::deque<GLuint> fifo;
+  size_t misses = 0;
+  for (size_t i = 0; i < indices.size(); ++i) {
+    if (std::find(fifo.begin(), fifo.end(), indices[i]) == fifo.end()) {
+      ++misses;
+      fifo.push_back(indices[i]);
+      if (fifo.size() > CACHE_SIZE) {
+        fifo.pop_front();
+      }
+    }
+  }
+  return (float)misses / (indices.size() / 3);
+}
+
+void MeshOptimizer::optimize(Mesh & mesh, const std::string & name) {
+  size_t vertexCount = mesh.positions.size();
+  float before = acmr(mesh.indices);
+  deduplicate(mesh);
+  optimizeVertexCache(mesh);
+  optimizeVertexFetch(mesh);
+  float after = acmr(mesh.indices);
+  SAY("%s: %d -> %d vertices, ACMR %.3f -> %.3f",
+    name.c_str(), (int)vertexCount, (int)mesh.positions.size(), before, after);
+}
+
+namespace Quadrics {
+  // Open edges are held in place by a plane at right angles to their
+  // triangle, weighted well above the surface itself
+  const float BOUNDARY_WEIGHT = 10.0f;
+
+  // The symmetric 4x4 matrix, upper triangle only.  The error of a point
+  // is the weighted sum of its squared distances to the planes added.
+  struct Quadric {
+    double a[10];
+
+    Quadric() {
+      std::fill(a, a + 10, 0.0);
+    }
+
+    // The plane through point with unit normal
+    Quadric(const vec3 & normal, const vec3 & point, float weight) {
+      double x = normal.x, y = normal.y, z = normal.z;
+      double d = -(x * point.x + y * point.y + z * point.z);
+      a[0] = x * x; a[1] = x * y; a[2] = x * z; a[3] = x * d;
+      a[4] = y * y; a[5] = y * z; a[6] = y * d;
+      a[7] = z * z; a[8] = z * d;
+      a[9] = d * d;
+      for (int i = 0; i < 10; ++i) {
+        a[i] *= weight;
+      }
+    }
+
+    void add(const Quadric & other) {
+      for (int i = 0; i < 10; ++i) {
+        a[i] += other.a[i];
+      }
+    }
+
+    double error(const vec3 & p) const {
+      double x = p.x, y = p.y, z = p.z;
+      return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z + 2 * a[3] * x +
+        a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y +
+        a[7] * z * z + 2 * a[8] * z +
+        a[9];
+    }
+  };
+
+  // Moving from onto to, along the edge between them
+  struct Collapse {
+    GLuint from;
+    GLuint to;
+    double error;
+
+    bool operator<(const Collapse & other) const {
+      return error < other.error;
+    }
+  };
+
+  vec3 faceNormal(const vec3 & a, const vec3 & b, const vec3 & c) {
+    return glm::cross(b - a, c - a);
+  }
+}
+
+void MeshOptimizer::simplify(Mesh & mesh, float ratio, const std::string & name) {
+  using namespace Quadrics;
+  size_t triangleCount = mesh.indices.size() / 3;
+  size_t target = (size_t)(triangleCount * ratio);
+
+  // Collapses work on positions rather than vertices
+  std::vector<GLuint> positionIds(mesh.positions.size());
+  std::vector<vec3> points;
+  std::vector<std::vector<GLuint>> positionVertices;
+  {
+    std::unordered_map<std::string, GLuint> unique;
+    std::string key;
+    for (size_t i = 0; i < mesh.positions.size(); ++i) {
+      key.clear();
+      key.append((const char *)&mesh.positions[i], sizeof(vec3));
+      auto inserted = unique.insert(std::make_pair(key, (GLuint)points.size()));
+      if (inserted.second) {
+        const vec4 & position = mesh.positions[i];
+        points.push_back(vec3(position.x, position.y, position.z));
+        positionVertices.push_back(std::vector<GLuint>());
+      }
+      positionIds[i] = inserted.first->second;
+      positionVertices[positionIds[i]].push_back(i);
+    }
+  }
+
+  std::vector<Quadric> quadrics(points.size());
+  {
+    std::unordered_map<uint64_t, int> edgeUses;
+    for (size_t t = 0; t < triangleCount; ++t) {
+      GLuint p[3];
+      for (int i = 0; i < 3; ++i) {
+        p[i] = positionIds[mesh.indices[t * 3 + i]];
+      }
+      vec3 normal = faceNormal(points[p[0]], points[p[1]], points[p[2]]);
+      float area = glm::length(normal);
+      if (0 == area) {
+        continue;
+      }
+      Quadric plane(normal / area, points[p[0]], area / 2);
+      for (int i = 0; i < 3; ++i) {
+        quadrics[p[i]].add(plane);
+        GLuint a = p[i], b = p[(i + 1) % 3];
+        ++edgeUses[((uint64_t)std::min(a, b) << 32) | std::max(a, b)];
+      }
+    }
+    for (size_t t = 0; t < triangleCount; ++t) {
+      GLuint p[3];
+      for (int i = 0; i < 3; ++i) {
+        p[i] = positionIds[mesh.indices[t * 3 + i]];
+      }
+      vec3 normal = faceNormal(points[p[0]], points[p[1]], points[p[2]]);
+      for (int i = 0; i < 3; ++i) {
+        GLuint a = p[i], b = p[(i + 1) % 3];
+        if (1 != edgeUses[((uint64_t)std::min(a, b) << 32) | std::max(a, b)]) {
+          continue;
+        }
+        vec3 edge = points[b] - points[a];
+        vec3 boundaryNormal = glm::cross(edge, normal);
+        float length = glm::length(boundaryNormal);
+        if (0 == length) {
+          continue;
+        }
+        Quadric plane(boundaryNormal / length, points[a], BOUNDARY_WEIGHT * glm::dot(edge, edge));
+        quadrics[a].add(plane);
+        quadrics[b].add(plane);
+      }
+    }
+  }
+
+  // Each pass collapses the cheapest edges it can without touching the
+  // neighbourhood of an earlier collapse in the same pass, so adjacency
+  // only has to be rebuilt between passes
+  std::vector<GLuint> corners(mesh.indices);
+  std::vector<GLuint> collapsed(points.size());
+  for (size_t i = 0; i < collapsed.size(); ++i) {
+    collapsed[i] = i;
+  }
+  std::vector<std::vector<GLuint>> positionTriangles(points.size());
+  std::vector<Collapse> collapses;
+  std::vector<bool> locked;
+  size_t live = triangleCount;
+  double maxError = 0;
+  while (live > target) {
+    // Drop the triangles the last pass collapsed away
+    std::vector<GLuint> remaining;
+    remaining.reserve(corners.size());
+    for (size_t t = 0; t < corners.size(); t += 3) {
+      GLuint p0 = positionIds[corners[t]];
+      GLuint p1 = positionIds[corners[t + 1]];
+      GLuint p2 = positionIds[corners[t + 2]];
+      if (p0 != p1 && p1 != p2 && p2 != p0) {
+        remaining.insert(remaining.end(), corners.begin() + t, corners.begin() + t + 3);
+      }
+    }
+    corners.swap(remaining);
+    live = corners.size() / 3;
+
+    for (size_t i = 0; i < positionTriangles.size(); ++i) {
+      positionTriangles[i].clear();
+    }
+    collapses.clear();
+    for (size_t t = 0; t < live; ++t) {
+      for (int i = 0; i < 3; ++i) {
+        GLuint a = positionIds[corners[t * 3 + i]];
+        GLuint b = positionIds[corners[t * 3 + (i + 1) % 3]];
+        positionTriangles[a].push_back(t);
+        Collapse ab = { a, b, quadrics[a].error(points[b]) + quadrics[b].error(points[b]) };
+        Collapse ba = { b, a, quadrics[a].error(points[a]) + quadrics[b].error(points[a]) };
+        collapses.push_back(ab < ba ? ab : ba);
+      }
+    }
+    std::sort(collapses.begin(), collapses.end());
+
+    locked.assign(points.size(), false);
+    size_t applied = 0;
+    for (size_t c = 0; c < collapses.size() && live > target; ++c) {
+      const Collapse & collapse = collapses[c];
+      if (locked[collapse.from] || locked[collapse.to]) {
+        continue;
+      }
+
+      // Reject collapses that would turn a triangle over
+      const std::vector<GLuint> & triangles = positionTriangles[collapse.from];
+      bool flips = false;
+      for (size_t i = 0; i < triangles.size() && !flips; ++i) {
+        GLuint p[3];
+        for (int j = 0; j < 3; ++j) {
+          p[j] = positionIds[corners[triangles[i] * 3 + j]];
+        }
+        if (p[0] == collapse.to || p[1] == collapse.to || p[2] == collapse.to) {
+          continue;
+        }
+        vec3 before = faceNormal(points[p[0]], points[p[1]], points[p[2]]);
+        for (int j = 0; j < 3; ++j) {
+          if (p[j] == collapse.from) {
+            p[j] = collapse.to;
+          }
+        }
+        vec3 after = faceNormal(points[p[0]], points[p[1]], points[p[2]]);
+        flips = glm::dot(before, after) <= 0;
+      }
+      if (flips) {
+        continue;
+      }
+
+      for (size_t i = 0; i < triangles.size(); ++i) {
+        bool shared = false;
+        for (int j = 0; j < 3; ++j) {
+          GLuint p = positionIds[corners[triangles[i] * 3 + j]];
+          locked[p] = true;
+          shared |= p == collapse.to;
+        }
+        if (shared) {
+          --live;
+        }
+      }
+      quadrics[collapse.to].add(quadrics[collapse.from]);
+      collapsed[collapse.from] = collapse.to;
+      maxError = std::max(maxError, collapse.error);
+      ++applied;
+    }
+    if (!applied) {
+      break;
+    }
+
+    // Move the corners of collapsed positions to the vertex at the new
+    // position whose normal is closest to their own
+    for (size_t i = 0; i < corners.size(); ++i) {
+      GLuint from = positionIds[corners[i]];
+      GLuint to = collapsed[from];
+      if (to == from) {
+        continue;
+      }
+      const std::vector<GLuint> & candidates = positionVertices[to];
+      GLuint best = candidates[0];
+      if (!mesh.normals.empty()) {
+        const vec4 & normal = mesh.normals[corners[i]];
+        float bestDot = -2;
+        for (size_t j = 0; j < candidates.size(); ++j) {
+          const vec4 & candidate = mesh.normals[candidates[j]];
+          float dot = normal.x * candidate.x + normal.y * candidate.y + normal.z * candidate.z;
+          if (dot > bestDot) {
+            bestDot = dot;
+            best = candidates[j];
+          }
+        }
+      }
+      corners[i] = best;
+    }
+    for (size_t i = 0; i < collapsed.size(); ++i) {
+      collapsed[i] = i;
+    }
+  }
+
+  std::vector<GLuint> indices;
+  indices.reserve(corners.size());
+  for (size_t t = 0; t < corners.size(); t += 3) {
+    GLuint p0 = positionIds[corners[t]];
+    GLuint p1 = positionIds[corners[t + 1]];
+    GLuint p2 = positionIds[corners[t + 2]];
+    if (p0 != p1 && p1 != p2 && p2 != p0) {
+      indices.insert(indices.end(), corners.begin() + t, corners.begin() + t + 3);
+    }
+  }
+  mesh.indices.swap(indices);
+  optimizeVertexCache(mesh);
+  optimizeVertexFetch(mesh);
+  SAY("%s: simplified %d -> %d triangles, error %.3g",
+    name.c_str(), (int)triangleCount, (int)(mesh.indices.size() / 3), maxError);
+}
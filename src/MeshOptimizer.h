@@ -0,0 +1,32 @@
+#pragma once
+
+// Load time optimizations for indexed triangle meshes
+class MeshOptimizer {
+private:
+  MeshOptimizer() {}
+
+public:
+  // The post transform cache size that's optimized for and simulated
+  static const int CACHE_SIZE = 32;
+
+  // Merges vertices whose attributes are all identical
+  static void deduplicate(Mesh & mesh);
+  // Reorders triangles for post transform cache hits, using Tom Forsyth's
+  // "Linear-Speed Vertex Cache Optimisation"
+  static void optimizeVertexCache(Mesh & mesh);
+  // Reorders vertices into the order they're first used, dropping any
+  // that aren't used at all
+  static void optimizeVertexFetch(Mesh & mesh);
+  // Average cache miss ratio: transformed vertices per triangle, with a
+  // CACHE_SIZE entry FIFO cache.  0.5 is ideal, 3 is no reuse at all.
+  static float acmr(const std::vector<GLuint> & indices);
+
+  // All of the above, reporting ACMR before and after
+  static void optimize(Mesh & mesh, const std::string & name);
+
+  // Collapses edges until about ratio of the triangles are left, cheapest
+  // first by Garland and Heckbert's quadric error metric.  Vertices keep
+  // their attributes, and those sharing a position collapse together, so
+  // seams stay closed.  The result is optimized as above.
+  static void simplify(Mesh & mesh, float ratio, const std::string & name);
+};
@@ -0,0 +1,103 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+Multires::Multires(const uvec2 & size) : size(size) {
+  Context gl;
+  gl.Bound(Texture::Target::_2D, color)
+    .MinFilter(TextureMinFilter::Linear)
+    .MagFilter(TextureMagFilter::Linear)
+    .WrapS(TextureWrap::ClampToEdge)
+    .WrapT(TextureWrap::ClampToEdge)
+    .Image2D(0, PixelDataInternalFormat::RGBA8,
+      size.x, size.y,
+      0, PixelDataFormat::RGB, PixelDataType::UnsignedByte, nullptr
+    );
+  gl.Bound(Renderbuffer::Target::Renderbuffer, depth)
+    .Storage(PixelDataInternalFormat::DepthComponent, size.x, size.y);
+  gl.Bound(Framebuffer::Target::Draw, fbo)
+    .AttachTexture(FramebufferAttachment::Color, color, 0)
+    .AttachRenderbuffer(FramebufferAttachment::Depth, depth)
+    .Complete();
+  DefaultFramebuffer().Bind(Framebuffer::Target::Draw);
+}
+
+void Multires::setConfig(const MultiresConfig & newConfig) {
+  config = newConfig;
+  config.center = glm::clamp(config.center, vec2(0.1f), vec2(1.0f));
+  config.peripheryScale = glm::clamp(config.peripheryScale, 0.1f, 1.0f);
+}
+
+// Splits [-1, 1] in three around the lens axis, which is where the
+// projection puts view space -Z
+static void splitAxis(float axis, float halfWidth, float edges[4]) {
+  axis = glm::clamp(axis, -1.0f + halfWidth, 1.0f - halfWidth);
+  edges[0] = -1.0f;
+  edges[1] = axis - halfWidth;
+  edges[2] = axis + halfWidth;
+  edges[3] = 1.0f;
+}
+
+Multires::EyeLayout Multires::layout(const mat4 & projection, const ivec2 & position, const uvec2 & eyeSize) const {
+  EyeLayout result;
+  float edgesX[4], edgesY[4];
+  splitAxis(-projection[2][0], config.center.x, edgesX);
+  splitAxis(-projection[2][1], config.center.y, edgesY);
+
+  // Packed column widths and row heights, and their offsets
+  float scales[3] = { config.peripheryScale, 1.0f, config.peripheryScale };
+  int widths[3], heights[3];
+  int offsetsX[4] = { 0 }, offsetsY[4] = { 0 };
+  for (int i = 0; i < 3; ++i) {
+    widths[i] = (int)(eyeSize.x * (edgesX[i + 1] - edgesX[i]) / 2.0f * scales[i] + 0.5f);
+    heights[i] = (int)(eyeSize.y * (edgesY[i + 1] - edgesY[i]) / 2.0f * scales[i] + 0.5f);
+    offsetsX[i + 1] = offsetsX[i] + widths[i];
+    offsetsY[i + 1] = offsetsY[i] + heights[i];
+  }
+
+  for (int row = 0; row < 3; ++row) {
+    for (int col = 0; col < 3; ++col) {
+      Region & region = result.regions[row * 3 + col];
+      // Maps the region's part of clip space to all of it
+      vec2 scale(2.0f / (edgesX[col + 1] - edgesX[col]), 2.0f / (edgesY[row + 1] - edgesY[row]));
+      vec2 center((edgesX[col] + edgesX[col + 1]) / 2.0f, (edgesY[row] + edgesY[row + 1]) / 2.0f);
+      region.projection = glm::scale(mat4(), vec3(scale, 1)) *
+        glm::translate(mat4(), vec3(-center, 0)) * projection;
+      region.position = position + ivec2(offsetsX[col], offsetsY[row]);
+      region.size = uvec2(widths[col], heights[row]);
+      result.shadedPixels += region.size.x * region.size.y;
+    }
+  }
+
+  result.splits = vec4(
+    (edgesX[1] + 1.0f) / 2.0f, (edgesX[2] + 1.0f) / 2.0f,
+    (edgesY[1] + 1.0f) / 2.0f, (edgesY[2] + 1.0f) / 2.0f);
+  for (int i = 0; i < 4; ++i) {
+    result.packedX[i] = (float)(position.x + offsetsX[i]) / size.x;
+    result.packedY[i] = (float)(position.y + offsetsY[i]) / size.y;
+  }
+  result.eyePixels = eyeSize.x * eyeSize.y;
+  return result;
+}
+
+void Multires::resolve(const EyeLayout & eyeLayout) {
+  GpuTimer::Scope timer("MRS resolve");
+  static const ProgramHandle program = GlUtils::getProgramHandle(
+    Resource::SHADERS_MULTIRESRESOLVE_VS, Resource::SHADERS_MULTIRESRESOLVE_FS);
+  Program & prog = GlUtils::getProgram(program);
+  prog.Use();
+  Uniform<vec4>(prog, Layout::Uniform::MultiresSplits).Set(eyeLayout.splits);
+  Uniform<vec4>(prog, Layout::Uniform::MultiresPackedX).Set(eyeLayout.packedX);
+  Uniform<vec4>(prog, Layout::Uniform::MultiresPackedY).Set(eyeLayout.packedY);
+
+  glDisable(GL_DEPTH_TEST);
+  glDisable(GL_BLEND);
+  color.Bind(Texture::Target::_2D);
+  emptyVao.Bind();
+  ++Geometry::drawCalls;
+  glDrawArrays(GL_TRIANGLES, 0, 3);
+  NoVertexArray().Bind();
+  NoProgram().Use();
+  glEnable(GL_BLEND);
+  glEnable(GL_DEPTH_TEST);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+// The split between full and reduced resolution, for Multires
+struct MultiresConfig {
+  // Size of the full resolution region, as a fraction of the eye's width
+  // and height.  It's centered on the lens axis.
+  vec2  center{ 0.6f, 0.6f };
+  // Resolution scale of the regions around it
+  float peripheryScale{ 0.5f };
+};
+
+// Fixed foveated rendering.  The lenses magnify the middle of each eye
+// texture and compress its edges, so the periphery can be rendered at a
+// lower resolution without visible loss.
+//
+// Each eye is split into a 3x3 grid of regions.  The center one renders
+// at full resolution and the others at peripheryScale, each with a
+// projection of just its part of the eye's frustum, into viewports packed
+// in the same grid in an intermediate framebuffer.  A resolve pass then
+// stretches them back over the eye's viewport, so the SDK is handed the
+// usual eye textures.
+class Multires {
+public:
+  static const int REGIONS = 9;
+
+  struct Region {
+    mat4  projection;
+    // The packed viewport
+    ivec2 position;
+    uvec2 size;
+  };
+
+  struct EyeLayout {
+    Region  regions[REGIONS];
+    // For MultiresResolve.fs
+    vec4    splits;
+    vec4    packedX;
+    vec4    packedY;
+    size_t  shadedPixels{ 0 };
+    size_t  eyePixels{ 0 };
+  };
+
+private:
+  MultiresConfig        config;
+  uvec2                 size;
+  oglplus::Texture      color;
+  oglplus::Renderbuffer depth;
+  oglplus::Framebuffer  fbo;
+  // The resolve draws a triangle from gl_VertexID alone, but a core
+  // profile still needs a VAO bound
+  oglplus::VertexArray  emptyVao;
+  size_t                shadedPixels{ 0 };
+  size_t                eyePixels{ 0 };
+
+public:
+  // The framebuffer covers size, which should be that of the eye
+  // framebuffer, and each eye's regions are packed at its own viewport's
+  // position
+  Multires(const uvec2 & size);
+
+  void setConfig(const MultiresConfig & config);
+  const MultiresConfig & getConfig() const {
+    return config;
+  }
+
+  // The fraction of the eyes' pixels shaded by the last frame
+  float getShadedFraction() const {
+    return eyePixels ? (float)shadedPixels / eyePixels : 1.0f;
+  }
+
+  // Call once per frame, before the eyes
+  void beginFrame() {
+    shadedPixels = 0;
+    eyePixels = 0;
+  }
+
+  EyeLayout layout(const mat4 & projection, const ivec2 & position, const uvec2 & eyeSize) const;
+
+  // Draws each region of an eye with drawRegion, which gets the region's
+  // projection, and resolves them into the eye's viewport of target.
+  // The scissor test is left enabled, as for any per eye drawing.
+  template <typename Function>
+  void renderEye(const mat4 & projection, const ivec2 & position, const uvec2 & eyeSize,
+      oglplus::Framebuffer & target, Function drawRegion) {
+    EyeLayout eyeLayout = layout(projection, position, eyeSize);
+    fbo.Bind(oglplus::Framebuffer::Target::Draw);
+    for (int i = 0; i < REGIONS; ++i) {
+      const Region & region = eyeLayout.regions[i];
+      if (!region.size.x || !region.size.y) {
+        continue;
+      }
+      glViewport(region.position.x, region.position.y, region.size.x, region.size.y);
+      glScissor(region.position.x, region.position.y, region.size.x, region.size.y);
+      drawRegion(region.projection);
+    }
+    target.Bind(oglplus::Framebuffer::Target::Draw);
+    glViewport(position.x, position.y, eyeSize.x, eyeSize.y);
+    glScissor(position.x, position.y, eyeSize.x, eyeSize.y);
+    resolve(eyeLayout);
+    shadedPixels += eyeLayout.shadedPixels;
+    eyePixels += eyeLayout.eyePixels;
+  }
+
+private:
+  void resolve(const EyeLayout & eyeLayout);
+};
@@ -0,0 +1,193 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+const float PieceRenderer::LOD_THRESHOLDS[SharedMesh::PIECE_LODS - 1] = { 360, 180, 90 };
+const float PieceRenderer::LOD_HYSTERESIS = 0.15f;
+const float PieceRenderer::PIECE_SCALE = 1.6f;
+
+mat4 PieceRenderer::getPieceTransform(int row, int col, Chess::Piece piece) {
+  MatrixStack mv;
+  mv.scale(GlUtils::CHESS_SCALE);
+  mv.translate(vec3(-3.5, 0, -3.5));
+  mv.translate(vec3(col, 0, 7 - row));
+  if (Chess::Side::WHITE == Chess::pieceSide(piece)) {
+    mv.rotate(PI, GlUtils::Y_AXIS);
+  }
+  mv.scale(PIECE_SCALE);
+  return mv.top();
+}
+
+vec4 PieceRenderer::getPieceColor(Chess::Piece piece) {
+  return vec4(Chess::Side::WHITE == Chess::pieceSide(piece) ?
+    Colors::white : Colors::dimGrey, 1);
+}
+
+Bounds PieceRenderer::getBoardBounds(const MeshBuffer & meshes) {
+  Bounds result = meshes.ranges[SharedMesh::CHESS_BOARD].bounds;
+  float height = 0;
+  for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+    height = std::max(height, meshes.ranges[type].bounds.max.y);
+  }
+  result.max.y += height * GlUtils::CHESS_SCALE * PIECE_SCALE;
+  return result;
+}
+
+float PieceRenderer::getPixelScale(const mat4 & projection, int viewportHeight) {
+  return projection[1][1] * viewportHeight / 2.0f;
+}
+
+float PieceRenderer::getProjectedSize(const mat4 & modelview, float pixelScale) {
+  static const float BOARD_SIZE = 8 * GlUtils::CHESS_SCALE;
+  float distance = glm::length(vec3(modelview[3]));
+  return BOARD_SIZE * pixelScale / std::max(distance, 0.01f);
+}
+
+int PieceRenderer::selectLod(float pixels, int current) {
+  int target = 0;
+  while (target < SharedMesh::PIECE_LODS - 1 && pixels < LOD_THRESHOLDS[target]) {
+    ++target;
+  }
+  // Only the threshold between the current level and the next one
+  // towards the target needs clearing
+  if (target > current && pixels > LOD_THRESHOLDS[current] * (1 - LOD_HYSTERESIS)) {
+    return current;
+  }
+  if (target < current && pixels < LOD_THRESHOLDS[current - 1] * (1 + LOD_HYSTERESIS)) {
+    return current;
+  }
+  return target;
+}
+
+// Both buffers are sized for a full board up front, so changes to either
+// are sub uploads rather than reallocations
+PieceRenderer::PieceRenderer() {
+  instanceBuffer.Bind(Buffer::Target::Array);
+  glBufferData(GL_ARRAY_BUFFER, MAX_PIECES * sizeof(InstanceData), nullptr, GL_DYNAMIC_DRAW);
+  NoBuffer().Bind(Buffer::Target::Array);
+  commandBuffer.Bind(Buffer::Target::DrawIndirect);
+  glBufferData(GL_DRAW_INDIRECT_BUFFER, MAX_PIECES * sizeof(DrawElementsIndirectCommand),
+    nullptr, GL_DYNAMIC_DRAW);
+  NoBuffer().Bind(Buffer::Target::DrawIndirect);
+}
+
+void PieceRenderer::setBoard(const Chess::Board & newBoard) {
+  if (memcmp(&board, &newBoard, sizeof(Chess::Board))) {
+    board = newBoard;
+    dirty = true;
+  }
+}
+
+void PieceRenderer::placePieces(const MeshBuffer & meshes) {
+  pieces.clear();
+  pieceTypes.clear();
+  pieceSpheres.clear();
+  for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+    Chess::forEachSquare([&](int row, int col){
+      Chess::Piece piece = board.position[row][col];
+      if (piece && Chess::pieceType(piece) == type && (int)pieces.size() < MAX_PIECES) {
+        InstanceData instance;
+        instance.transform = getPieceTransform(row, col, piece);
+        instance.color = getPieceColor(piece);
+        pieces.push_back(instance);
+        pieceTypes.push_back(type);
+        pieceSpheres.add(meshes.ranges[type].bounds, instance.transform);
+      }
+    });
+  }
+  if (!pieces.empty()) {
+    instanceBuffer.Bind(Buffer::Target::Array);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, pieces.size() * sizeof(InstanceData), &pieces[0]);
+    NoBuffer().Bind(Buffer::Target::Array);
+  }
+  placedMeshes = meshes.version;
+  dirty = false;
+}
+
+// The instances are grouped by type, so each run of visible neighbours of
+// one type is a single command
+void PieceRenderer::updateCommands(const MeshBuffer & meshes) {
+  DrawElementsIndirectCommand commands[MAX_PIECES];
+  commandCount = 0;
+  for (size_t piece = 0; piece < pieces.size(); ++piece) {
+    if (!visible[piece]) {
+      continue;
+    }
+    int type = pieceTypes[piece];
+    size_t first = piece;
+    while (piece + 1 < pieces.size() && visible[piece + 1] && pieceTypes[piece + 1] == type) {
+      ++piece;
+    }
+    commands[commandCount++] = meshes.getCommand(SharedMesh::pieceLod(type, lod),
+      piece + 1 - first, first);
+  }
+
+  if (commandCount) {
+    commandBuffer.Bind(Buffer::Target::DrawIndirect);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0,
+      commandCount * sizeof(DrawElementsIndirectCommand), commands);
+    NoBuffer().Bind(Buffer::Target::DrawIndirect);
+  }
+  commandViews = Geometry::viewCount;
+  commandMeshes = meshes.version;
+  commandVisible = visible;
+  commandsDirty = false;
+}
+
+void PieceRenderer::update(float pixelScale) {
+  MeshBuffer & meshes = GlUtils::getSharedMeshes();
+  if (dirty || placedMeshes != meshes.version) {
+    placePieces(meshes);
+    commandsDirty = true;
+  }
+  int newLod = selectLod(getProjectedSize(Stacks::modelview().top(), pixelScale), lod);
+  if (newLod != lod) {
+    lod = newLod;
+    commandsDirty = true;
+  }
+}
+
+void PieceRenderer::render() {
+  MeshBuffer & meshes = GlUtils::getSharedMeshes();
+  const mat4 & modelview = Stacks::modelview().top();
+  bool rebuild = commandsDirty || commandViews != Geometry::viewCount ||
+    commandMeshes != meshes.version;
+  // The visible set can differ between views.  Only the commands follow
+  // it, so a piece near a frustum edge costs a few bytes of upload per
+  // view, never a reallocation.
+  int visibleCount = Culling::cull(pieceSpheres, modelview, visible);
+  if (rebuild || visible != commandVisible) {
+    updateCommands(meshes);
+  }
+
+  meshes.bind();
+  if (visibleCount) {
+    static const ProgramHandle program = GlUtils::getProgramHandle(
+      Resource::SHADERS_LITCOLOREDINSTANCED_VS,
+      Resource::SHADERS_LITCOLORED_FS);
+    Program & prog = GlUtils::getProgram(program);
+    prog.Use();
+    DrawBlock draw(Stacks::modelview().top());
+    draw.instanceTransformActive = 1;
+    Uniforms::setDraw(draw);
+
+    Geometry::bindInstances(instanceBuffer);
+    commandBuffer.Bind(Buffer::Target::DrawIndirect);
+    ++Geometry::drawCalls;
+    glMultiDrawElementsIndirect(meshes.elementType, meshes.indexType,
+      nullptr, commandCount, 0);
+    NoBuffer().Bind(Buffer::Target::DrawIndirect);
+  }
+
+  if (Culling::isVisible(meshes.ranges[SharedMesh::CHESS_BOARD].bounds, modelview)) {
+    static const ProgramHandle program = GlUtils::getProgramHandle(
+      Resource::SHADERS_COLORED_VS,
+      Resource::SHADERS_COLORED_FS);
+    Program & prog = GlUtils::getProgram(program);
+    prog.Use();
+    Uniforms::setDraw();
+    meshes.draw(SharedMesh::CHESS_BOARD);
+  }
+  NoVertexArray().Bind();
+  NoProgram().Use();
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Draws a board and its pieces from GlUtils::getSharedMeshes, with a
+// single VAO bind.  The pieces are one glMultiDrawElementsIndirect using
+// LitColoredInstanced.vs.  Every piece's transform and color is uploaded
+// once per board change.  Culling only rebuilds the commands, one per run
+// of visible pieces of a type, which are rewritten in place when the set
+// of pieces in view changes.
+class PieceRenderer {
+public:
+  // A board can never hold more than 32 pieces
+  static const int MAX_PIECES = 32;
+
+private:
+  oglplus::Buffer instanceBuffer;
+  oglplus::Buffer commandBuffer;
+  int             commandCount{ 0 };
+  Chess::Board    board;
+  bool            dirty{ true };
+  // The pieces on the board grouped by type, as placed for the
+  // MeshBuffer::version in placedMeshes
+  std::vector<InstanceData> pieces;
+  std::vector<int> pieceTypes;
+  SphereSet       pieceSpheres;
+  uint32_t        placedMeshes{ 0 };
+  // Which pieces are in view, and which the commands were built from
+  std::vector<uint8_t> visible;
+  std::vector<uint8_t> commandVisible;
+  // The Geometry::viewCount and MeshBuffer::version the commands were
+  // built for
+  int             commandViews{ 0 };
+  uint32_t        commandMeshes{ 0 };
+  // Set when the pieces or their level change, until the commands follow
+  bool            commandsDirty{ true };
+  int             lod{ 0 };
+
+public:
+  static const float PIECE_SCALE;
+  // The projected board height, in pixels, below which each level of
+  // detail past the first is used
+  static const float LOD_THRESHOLDS[SharedMesh::PIECE_LODS - 1];
+  // How far past a threshold, as a fraction of it, the board has to be
+  // before the level changes, so boards sitting on a threshold don't
+  // flicker between levels
+  static const float LOD_HYSTERESIS;
+
+  // The transform of a piece relative to the center of the board
+  static mat4 getPieceTransform(int row, int col, Chess::Piece piece);
+  static vec4 getPieceColor(Chess::Piece piece);
+  // The board and the space above it its pieces can take up
+  static Bounds getBoardBounds(const MeshBuffer & meshes);
+
+  // Pixels per unit of size at unit distance, for a projection drawn into
+  // a viewport viewportHeight pixels high
+  static float getPixelScale(const mat4 & projection, int viewportHeight);
+  // The height in pixels of a board drawn with modelview
+  static float getProjectedSize(const mat4 & modelview, float pixelScale);
+  // The level of detail for a board of the projected size, currently
+  // drawn at level current
+  static int selectLod(float pixels, int current);
+
+  PieceRenderer();
+
+  void setBoard(const Chess::Board & board);
+  // Call once per frame, before any render calls, with the camera set.
+  // Places the pieces if the board changed, and picks their level of
+  // detail for the eye's pixelScale, see getPixelScale.  The level then
+  // holds for every view of the frame, so the eyes and multires regions
+  // all draw the same one.
+  void update(float pixelScale);
+  // Uses the lighting already set with Uniforms::setLights.  Pieces
+  // outside the Culling views are skipped.
+  void render();
+
+private:
+  void placePieces(const MeshBuffer & meshes);
+  void updateCommands(const MeshBuffer & meshes);
+};
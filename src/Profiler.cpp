@@ -0,0 +1,107 @@
+#include "Common.h"
+
+struct ProfilerEvent {
+  const char * name;
+  int64_t start;
+  int64_t duration;
+};
+
+// Written only by its own thread.  The count is published after each
+// event, so a reader sees whole events up to it, less any the writer has
+// since lapped.
+struct ThreadZones {
+  int id;
+  std::string name;
+  std::atomic<uint32_t> count;
+  ProfilerEvent events[Profiler::CAPACITY];
+
+  ThreadZones(int id) : id(id), name(Platform::format("Thread %d", id)), count(0) {
+  }
+};
+
+// Buffers outlive their threads, so a dump still shows threads that have
+// finished, like the asset loader's workers
+static void keepZones(ThreadZones *) {
+}
+
+static boost::mutex threadsMutex;
+static std::vector<ThreadZones *> threads;
+static boost::thread_specific_ptr<ThreadZones> currentThread(&keepZones);
+
+static ThreadZones & getThreadZones() {
+  ThreadZones * zones = currentThread.get();
+  if (!zones) {
+    withScopedLock(threadsMutex, [&](const boost::mutex::scoped_lock &){
+      zones = new ThreadZones(threads.size() + 1);
+      threads.push_back(zones);
+    });
+    currentThread.reset(zones);
+  }
+  return *zones;
+}
+
+Profiler::Zone::~Zone() {
+  ThreadZones & zones = getThreadZones();
+  uint32_t count = zones.count.load(std::memory_order_relaxed);
+  ProfilerEvent & event = zones.events[count % CAPACITY];
+  event.name = name;
+  event.start = start;
+  event.duration = Platform::elapsedNanos() - start;
+  zones.count.store(count + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string & name) {
+  ThreadZones & zones = getThreadZones();
+  withScopedLock(threadsMutex, [&](const boost::mutex::scoped_lock &){
+    zones.name = name;
+  });
+}
+
+bool Profiler::dump(const std::string & filename) {
+  std::string json = "{\"traceEvents\":[\n";
+  std::vector<ProfilerEvent> events;
+  size_t total = 0;
+  withScopedLock(threadsMutex, [&](const boost::mutex::scoped_lock &){
+    for (size_t i = 0; i < threads.size(); ++i) {
+      ThreadZones & zones = *threads[i];
+      uint32_t end = zones.count.load(std::memory_order_acquire);
+      uint32_t begin = end > CAPACITY ? end - CAPACITY : 0;
+      events.clear();
+      for (uint32_t j = begin; j < end; ++j) {
+        events.push_back(zones.events[j % CAPACITY]);
+      }
+      // Drop anything the thread overwrote while it was being copied.  The
+      // slot for index after is filled before count is published, so the
+      // event it replaces may have been half written too.
+      uint32_t after = zones.count.load(std::memory_order_acquire);
+      size_t skip = 0;
+      if (after + 1 > CAPACITY && after + 1 - CAPACITY > begin) {
+        skip = std::min<size_t>(after + 1 - CAPACITY - begin, events.size());
+      }
+
+      json += Platform::format(
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+        zones.id, zones.name.c_str());
+      for (size_t j = skip; j < events.size(); ++j) {
+        const ProfilerEvent & event = events[j];
+        // Microseconds, as trace_event expects
+        json += Platform::format(
+          "{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f},\n",
+          event.name, zones.id, (double)event.start / 1e3, (double)event.duration / 1e3);
+      }
+      total += events.size() - skip;
+    }
+  });
+  // Trailing commas aren't valid JSON
+  if (json[json.size() - 2] == ',') {
+    json.erase(json.size() - 2, 1);
+  }
+  json += "],\"displayTimeUnit\":\"ms\"}\n";
+
+  if (!Files::replace(filename, json.data(), json.size())) {
+    SAY_ERR("Unable to write the profile to %s", filename.c_str());
+    return false;
+  }
+  SAY("Wrote %d zones to %s", (int)total, filename.c_str());
+  return true;
+}
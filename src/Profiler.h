@@ -0,0 +1,34 @@
+#pragma once
+
+// A scoped zone profiler for the CPU.  Each thread records its zones into
+// its own ring buffer, so recording takes no locks, and only the last
+// CAPACITY zones of each thread are kept.  Timestamps come from
+// Platform::elapsedNanos.
+//
+//   void drawFrame() {
+//     Profiler::Zone zone("drawFrame");
+//     ...
+//   }
+class Profiler {
+  Profiler() {}
+
+public:
+  static const int CAPACITY = 8192;
+
+  // Records the time between construction and destruction.  The name
+  // should be a literal, or otherwise outlive the profiler.
+  class Zone {
+    const char * name;
+    int64_t start;
+  public:
+    Zone(const char * name) : name(name), start(Platform::elapsedNanos()) {
+    }
+    ~Zone();
+  };
+
+  // Labels the calling thread in dumps
+  static void setThreadName(const std::string & name);
+  // Writes every thread's zones as Chrome trace_event JSON, for
+  // chrome://tracing.  Safe to call while other threads are recording.
+  static bool dump(const std::string & filename);
+};
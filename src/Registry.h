@@ -0,0 +1,41 @@
+#pragma once
+
+// Resolves keys to dense integer handles, so that lookups after the first
+// are an index into a flat array rather than a map search.  Handles stay
+// valid for the life of the registry, and entries can be iterated in
+// handle order.  Entries may move as the registry grows, so hand out
+// references to what they own rather than to the entries themselves.
+template <typename Key, typename Entry>
+class Registry {
+  std::map<Key, int> handles;
+  std::vector<Key> keys;
+  std::vector<Entry> entries;
+
+public:
+  // Adds an empty entry the first time a key is seen
+  int resolve(const Key & key) {
+    typename std::map<Key, int>::const_iterator itr = handles.find(key);
+    if (handles.end() != itr) {
+      return itr->second;
+    }
+    int handle = entries.size();
+    handles[key] = handle;
+    keys.push_back(key);
+    entries.push_back(Entry());
+    return handle;
+  }
+
+  int size() const {
+    return entries.size();
+  }
+
+  const Key & key(int handle) const {
+    assert(handle >= 0 && handle < (int)keys.size());
+    return keys[handle];
+  }
+
+  Entry & operator[](int handle) {
+    assert(handle >= 0 && handle < (int)entries.size());
+    return entries[handle];
+  }
+};
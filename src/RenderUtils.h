@@ -9,10 +9,7 @@ public:
   static void renderGeometry(oglplus::Program & program, Geometry & geometry) {
     using namespace oglplus;
     program.Use();
-    Uniform<mat4>(program, Layout::Uniform::Projection)
-      .Set(Stacks::projection().top());
-    Uniform<mat4>(program, Layout::Uniform::ModelView)
-      .Set(Stacks::modelview().top());
+    Uniforms::setDraw();
     geometry.bind();
     geometry.draw();
     NoVertexArray().Bind();
@@ -20,54 +17,45 @@ public:
   }
 
   static void renderProceduralSkybox(Resource fragmentShader) {
-    using namespace oglplus;
-    Program & prog = GlUtils::getProgram(
-      Resource::SHADERS_CUBEMAP_VS, fragmentShader);
-
-    // Skybox texture
-    static Geometry cube(
-      [&](Buffer & vertexBuffer, Buffer & indexBuffer, VertexArray & vao){
-      GlUtils::getCubeVertices(vertexBuffer);
-      GlUtils::getCubeIndices(indexBuffer);
-      vao.Bind();
-      vertexBuffer.Bind(Buffer::Target::Array);
-      indexBuffer.Bind(Buffer::Target::ElementArray);
-      VertexArrayAttrib(Layout::Attribute::Position).
-        Pointer(3, DataType::Float, false, sizeof(vec4), nullptr).
-        Enable();
-      NoVertexArray().Bind();
-      NoBuffer().Bind(Buffer::Target::Array);
-      NoBuffer().Bind(Buffer::Target::ElementArray);
-    }, 36);
+    renderProceduralSkybox(GlUtils::getProgramHandle(
+      Resource::SHADERS_CUBEMAP_VS, fragmentShader));
+  }
 
-    Context & gl = GlUtils::context();
-    gl.Disable(Capability::DepthTest);
-    gl.CullFace(Face::Front);
+  static void renderProceduralSkybox(ProgramHandle program) {
+    GpuTimer::Scope timer("Skybox");
+    renderProceduralSkybox(program, Platform::elapsedMillis() / 1000.0f);
+  }
 
+  // Untimed, so SkyboxCache can account for its face updates separately
+  static void renderProceduralSkybox(ProgramHandle program, float time) {
+    using namespace oglplus;
+    Program & prog = GlUtils::getProgram(program);
     prog.Bind();
-    Uniform<float>(prog, Layout::Uniform::Time)
-      .Set(Platform::elapsedMillis() / 1000.0f);
-    MatrixStack & mv = Stacks::modelview();
-    mv.withPush([&]{
-      renderGeometry(prog, cube);
-    });
-
-    NoVertexArray().Bind();
-    NoProgram().Bind();
-    gl.CullFace(Face::Back);
-    gl.Enable(Capability::DepthTest);
-
+    Uniform<float>(prog, Layout::Uniform::Time).Set(time);
+    renderSkyboxCube(prog);
   }
 
   static void renderSkybox(Resource firstResource) {
+    renderSkybox(GlUtils::getCubemapTexture(firstResource));
+  }
+
+  static void renderSkybox(oglplus::Texture & cubemap) {
     using namespace oglplus;
-    static Program & prog = GlUtils::getProgram(
+    GpuTimer::Scope timer("Skybox");
+    static const ProgramHandle program = GlUtils::getProgramHandle(
         Resource::SHADERS_CUBEMAP_VS,
         Resource::SHADERS_CUBEMAP_FS);
+    Program & prog = GlUtils::getProgram(program);
+    auto boundTexture = GlUtils::context().Bound(Texture::Target::CubeMap, cubemap);
+    renderSkyboxCube(prog);
+  }
 
-    // Skybox texture
+private:
+  // Draws the inside of a cube around the eye, without depth
+  static void renderSkyboxCube(oglplus::Program & prog) {
+    using namespace oglplus;
     static Geometry cube(
-        [&](Buffer & vertexBuffer, Buffer & indexBuffer, VertexArray & vao){
+      [&](Buffer & vertexBuffer, Buffer & indexBuffer, VertexArray & vao){
       GlUtils::getCubeVertices(vertexBuffer);
       GlUtils::getCubeIndices(indexBuffer);
       vao.Bind();
@@ -85,17 +73,8 @@ public:
     gl.Disable(Capability::DepthTest);
     gl.CullFace(Face::Front);
 
-    prog.Bind();
-    //Uniform<float>(prog, Layout::Uniform::Time)
-    //  .Set(Platform::elapsedMillis() / 1000.0f);
     MatrixStack & mv = Stacks::modelview();
     mv.withPush([&]{
-      auto boundTexture = gl.Bound(Texture::Target::CubeMap,
-        GlUtils::getCubemapTexture(firstResource));
-  //    Uniform<mat4>(prog, Layout::Uniform::Projection).Set(Stacks::projection().top());
-  //    Uniform<mat4>(prog, Layout::Uniform::ModelView).Set(Stacks::modelview().top());
-  //    prog.Bind();
-  //    cube.draw();
       renderGeometry(prog, cube);
     });
 
@@ -0,0 +1,144 @@
+#include "Common.h"
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+// Static storage, so these start at zero
+static std::atomic<uint32_t> generations[NO_RESOURCE];
+static std::atomic<uint32_t> anyGeneration;
+static std::atomic<bool> running;
+static boost::thread watcherThread;
+
+typedef std::pair<Resource, std::string> WatchedFile;
+typedef std::vector<WatchedFile> WatchedFiles;
+
+static void changed(Resource resource) {
+  ++generations[resource];
+  ++anyGeneration;
+  SAY("%s changed", Platform::getResourcePath(resource).c_str());
+}
+
+#ifdef __linux__
+
+static void watch(WatchedFiles files) {
+  int fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fd < 0) {
+    SAY_ERR("Unable to start inotify, resources won't reload");
+    return;
+  }
+
+  // inotify reports changes by directory and file name
+  std::map<std::string, int> directoryWatches;
+  std::map<int, std::string> watchDirectories;
+  std::map<std::string, std::vector<Resource>> fileResources;
+  for (size_t i = 0; i < files.size(); ++i) {
+    const std::string & file = files[i].second;
+    size_t slash = file.find_last_of('/');
+    std::string directory = (std::string::npos == slash) ? "." : file.substr(0, slash);
+    std::string name = file.substr(slash + 1);
+    if (!directoryWatches.count(directory)) {
+      // Editors often save by renaming a new file over the old one
+      int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+      directoryWatches[directory] = wd;
+      if (wd >= 0) {
+        watchDirectories[wd] = directory;
+      }
+    }
+    fileResources[directory + "/" + name].push_back(files[i].first);
+  }
+
+  union {
+    inotify_event event;
+    char bytes[4096];
+  } buffer;
+  while (running) {
+    pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+    // Wakes periodically to check for stop
+    if (poll(&pfd, 1, 250) <= 0) {
+      continue;
+    }
+    ssize_t length = read(fd, buffer.bytes, sizeof(buffer.bytes));
+    for (ssize_t offset = 0; offset < length; ) {
+      const inotify_event * event = (const inotify_event *)(buffer.bytes + offset);
+      offset += sizeof(inotify_event) + event->len;
+      if (!event->len || !watchDirectories.count(event->wd)) {
+        continue;
+      }
+      std::string file = watchDirectories[event->wd] + "/" + event->name;
+      std::map<std::string, std::vector<Resource>>::const_iterator itr = fileResources.find(file);
+      if (fileResources.end() == itr) {
+        continue;
+      }
+      for (size_t i = 0; i < itr->second.size(); ++i) {
+        changed(itr->second[i]);
+      }
+    }
+  }
+  close(fd);
+}
+
+#else
+
+static void watch(WatchedFiles files) {
+  std::vector<time_t> modified(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    modified[i] = Platform::getResourceModified(files[i].first);
+  }
+  while (running) {
+    Platform::sleepMillis(500);
+    for (size_t i = 0; i < files.size(); ++i) {
+      time_t now = Platform::getResourceModified(files[i].first);
+      if (now != modified[i]) {
+        modified[i] = now;
+        changed(files[i].first);
+      }
+    }
+  }
+}
+
+#endif
+
+void ResourceWatcher::start() {
+  if (running) {
+    return;
+  }
+  // Looked up here, since the resource path table isn't thread safe
+  WatchedFiles files;
+  for (int i = 0; i < NO_RESOURCE; ++i) {
+    Resource resource = static_cast<Resource>(i);
+    std::string file = Platform::getResourceFile(resource);
+    if (!file.empty()) {
+      files.push_back(WatchedFile(resource, file));
+    }
+  }
+  if (files.empty()) {
+    return;
+  }
+  running = true;
+  watcherThread = boost::thread([files] {
+    Profiler::setThreadName("Resource watcher");
+    watch(files);
+  });
+}
+
+void ResourceWatcher::stop() {
+  if (!running) {
+    return;
+  }
+  running = false;
+  watcherThread.join();
+}
+
+uint32_t ResourceWatcher::getGeneration(Resource resource) {
+  return generations[resource];
+}
+
+uint32_t ResourceWatcher::getAnyGeneration() {
+  return anyGeneration;
+}
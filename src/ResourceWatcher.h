@@ -0,0 +1,22 @@
+#pragma once
+
+// Watches the resource files on a thread of its own, so caches can check
+// for changes without touching the disk.  Each resource has a generation
+// that's bumped whenever its file changes, and a cache rebuilds anything
+// whose generation differs from the one it was built from.
+//
+// Uses inotify on Linux, and elsewhere polls modification times on the
+// watcher thread.  Resources embedded in the binary never change.
+class ResourceWatcher {
+  ResourceWatcher() {}
+
+public:
+  // Call from the main thread
+  static void start();
+  static void stop();
+
+  // Zero until the resource first changes.  Safe from any thread.
+  static uint32_t getGeneration(Resource resource);
+  // Bumped whenever any resource changes.  Safe from any thread.
+  static uint32_t getAnyGeneration();
+};
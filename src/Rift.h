@@ -195,10 +195,17 @@ public:
   struct PerEyeArgs {
     //ovrEyeRenderDesc ovrEyeDesc;
     mat4 projection;
-    oglplus::Texture      color_tex;
-    oglplus::Renderbuffer depth_rbo;
-    oglplus::Framebuffer  fbo;
     mat4 viewAdjust;
+    // This eye's half of the shared framebuffer
+    ivec2 viewportPosition;
+    uvec2 viewportSize;
+  };
+
+  enum class StereoMode {
+    // Draw the scene once for each eye
+    PER_EYE,
+    // Draw the scene once, with every draw instanced for both eyes
+    SINGLE_PASS,
   };
 
 protected:
@@ -208,14 +215,66 @@ protected:
   PerEyeArgs  eyesArgs[2];
   ovrHmd      hmd;
   ovrTexture  ovrTextures[2];
+  int         frameIndex{ 0 };
+  StereoMode  stereoMode{ StereoMode::PER_EYE };
+
+  // Both eyes render side by side into one framebuffer, so either stereo
+  // mode can fill it
+  uvec2                 frameBufferSize;
+  oglplus::Texture      color_tex;
+  oglplus::Renderbuffer depth_rbo;
+  oglplus::Framebuffer  fbo;
+
+  // CPU time spent submitting frames, reported periodically per mode
+  int64_t     submitNanos{ 0 };
+  int         submitFrames{ 0 };
+
+  // The framebuffer is sized for the HMD's full pixel density, but the
+  // eyes render side by side into its bottom left corner, scaled by
+  // resolutionScale to keep the GPU time for a frame within budget.  The
+  // ovrTexture RenderViewports tell the SDK which part to distort.
+  uvec2       maxEyeSize;
+  float       resolutionScale{ 1.0f };
+  bool        adaptiveResolution{ true };
+  // Frames to wait for GPU timings taken at the current scale
+  int         settleFrames{ 0 };
+  // Consecutive frames well under budget
+  int         fastFrames{ 0 };
+  ovrPosef    renderPoses[2];
+
+  // When an app enables frameReuse, and tells us nothing in its scene
+  // changed with invalidateScene, frames where the eyes have barely moved
+  // since the last one rendered hand the SDK that frame's textures and
+  // poses again, and timewarp reprojects them.
+  bool        frameReuse{ false };
+  bool        sceneChanged{ true };
+  // The eye views the framebuffer was last rendered with
+  mat4        renderedViews[2];
+  // Consecutive frames reused
+  int         reusedFrames{ 0 };
+  // Whether each of the frames GpuTimer has yet to read back was reused,
+  // indexed by frameIndex
+  bool        reusedHistory[GpuTimer::RING_FRAMES];
+  int         reportFrames{ 0 };
+  int         reportReused{ 0 };
+
+  // Fixed foveated rendering for the per eye path, created when first
+  // enabled.  Single pass stereo always renders at full resolution.
+  std::unique_ptr<Multires> multires;
+  bool        multiresEnabled{ false };
 
 public:
   RiftApp(const RiftWrapperArgs & args) :
       hmd(args.hmd), windowSize(args.windowSize)
   {
+    memset(reusedHistory, 0, sizeof(reusedHistory));
     initGl();
   }
 
+  virtual ~RiftApp() {
+    Geometry::viewCount = 1;
+  }
+
   void initGl() {
     ovrGLConfig cfg;
     memset(&cfg, 0, sizeof(cfg));
@@ -238,50 +297,63 @@ public:
 
     float    orthoDistance = 0.8f; // 2D is 0.8 meter from camera
 
+    // Single pass stereo splits clip space down the middle, so both
+    // halves of the framebuffer need to be the same size
+    uvec2 eyeSize;
+    for_each_eye([&](ovrEyeType eye){
+      uvec2 size = Rift::fromOvr(ovrHmd_GetFovTextureSize(hmd, eye, fovs[eye], 1.0f));
+      eyeSize = glm::max(eyeSize, size);
+    });
+    frameBufferSize = uvec2(eyeSize.x * 2, eyeSize.y);
+    maxEyeSize = eyeSize;
+
     for_each_eye([&](ovrEyeType eye){
       PerEyeArgs & eyeArgs = eyesArgs[eye];
       const ovrFovPort & fov = fovs[eye];
 
-      ovrTexture & ovrTexture = ovrTextures[eye];
-      memset(&ovrTexture, 0, sizeof(ovrGLTexture));
-
       eyeArgs.viewAdjust = glm::translate(glm::mat4(), Rift::fromOvr(eyeRenderDescs[eye].ViewAdjust));
-
-      ovrTextureHeader & eyeTextureHeader = ovrTexture.Header;
-      eyeTextureHeader.TextureSize = ovrHmd_GetFovTextureSize(hmd, eye, fov, 1.0f);
-      eyeTextureHeader.RenderViewport.Size = eyeTextureHeader.TextureSize;
-      eyeTextureHeader.API = ovrRenderAPI_OpenGL;
+      eyeArgs.viewportPosition = ivec2(ovrEye_Left == eye ? 0 : eyeSize.x, 0);
+      eyeArgs.viewportSize = eyeSize;
 
       ovrMatrix4f ovrPerspectiveProjection = ovrMatrix4f_Projection(fov, 0.01f, 100.0f, true);
       eyeArgs.projection = Rift::fromOvr(ovrPerspectiveProjection);
 
-      // Allocate the frameBuffer that will hold the scene, and then be
-      // re-rendered to the screen with distortion
-      uvec2 frameBufferSize = Rift::fromOvr(eyeTextureHeader.TextureSize);
-
-      using namespace oglplus;
-      gl.Bound(Texture::Target::_2D, eyeArgs.color_tex)
-        .MinFilter(TextureMinFilter::Linear)
-        .MagFilter(TextureMagFilter::Linear)
-        .WrapS(TextureWrap::ClampToEdge)
-        .WrapT(TextureWrap::ClampToEdge)
-        .Image2D(0, PixelDataInternalFormat::RGBA8,
-          frameBufferSize.x, frameBufferSize.y,
-          0, PixelDataFormat::RGB, PixelDataType::UnsignedByte, nullptr
-        );
-
-      gl.Bound(Renderbuffer::Target::Renderbuffer, eyeArgs.depth_rbo)
-        .Storage(
-          PixelDataInternalFormat::DepthComponent,
-          frameBufferSize.x,
-          frameBufferSize.y
-        );
-
-      gl.Bound(Framebuffer::Target::Draw, eyeArgs.fbo)
-        .AttachTexture(FramebufferAttachment::Color, eyeArgs.color_tex, 0)
-        .AttachRenderbuffer(FramebufferAttachment::Depth, eyeArgs.depth_rbo)
-        .Complete();
-      ((ovrGLTexture&)ovrTexture).OGL.TexId = GetName(eyeArgs.color_tex);
+      ovrTexture & ovrTexture = ovrTextures[eye];
+      memset(&ovrTexture, 0, sizeof(ovrGLTexture));
+      ovrTextureHeader & eyeTextureHeader = ovrTexture.Header;
+      eyeTextureHeader.TextureSize = Rift::toOvr(frameBufferSize);
+      eyeTextureHeader.RenderViewport.Pos.x = eyeArgs.viewportPosition.x;
+      eyeTextureHeader.RenderViewport.Pos.y = eyeArgs.viewportPosition.y;
+      eyeTextureHeader.RenderViewport.Size = Rift::toOvr(eyeSize);
+      eyeTextureHeader.API = ovrRenderAPI_OpenGL;
+    });
+
+    // Allocate the frameBuffer that will hold the scene, and then be
+    // re-rendered to the screen with distortion
+    using namespace oglplus;
+    gl.Bound(Texture::Target::_2D, color_tex)
+      .MinFilter(TextureMinFilter::Linear)
+      .MagFilter(TextureMagFilter::Linear)
+      .WrapS(TextureWrap::ClampToEdge)
+      .WrapT(TextureWrap::ClampToEdge)
+      .Image2D(0, PixelDataInternalFormat::RGBA8,
+        frameBufferSize.x, frameBufferSize.y,
+        0, PixelDataFormat::RGB, PixelDataType::UnsignedByte, nullptr
+      );
+
+    gl.Bound(Renderbuffer::Target::Renderbuffer, depth_rbo)
+      .Storage(
+        PixelDataInternalFormat::DepthComponent,
+        frameBufferSize.x,
+        frameBufferSize.y
+      );
+
+    gl.Bound(Framebuffer::Target::Draw, fbo)
+      .AttachTexture(FramebufferAttachment::Color, color_tex, 0)
+      .AttachRenderbuffer(FramebufferAttachment::Depth, depth_rbo)
+      .Complete();
+    for_each_eye([&](ovrEyeType eye){
+      ((ovrGLTexture&)ovrTextures[eye]).OGL.TexId = GetName(color_tex);
     });
 
     ///////////////////////////////////////////////////////////////////////////
@@ -298,46 +370,317 @@ public:
   }
 
   void onTick() {
-    updateState();
-    drawFrame();
+    Profiler::Zone zone("onTick");
+    GpuTimer::beginFrame();
+    Uniforms::beginFrame();
+    adaptResolution();
+    ovrHmd_BeginFrame(hmd, frameIndex);
+    bool reused;
+    {
+      // All of the frame's GPU work but the SDK's distortion
+      GpuTimer::Scope timer("Frame");
+      {
+        Profiler::Zone zone("updateState");
+        updateState();
+      }
+      reused = canReuseFrame();
+      if (!reused) {
+        drawFrame();
+      }
+    }
+    reusedHistory[frameIndex % GpuTimer::RING_FRAMES] = reused;
+    endFrame();
   }
 
   virtual void updateState() = 0;
   virtual void drawScene() = 0;
 
+  // Call from updateState whenever anything drawn changes
+  void invalidateScene() {
+    sceneChanged = true;
+  }
+
+  void setStereoMode(StereoMode mode) {
+    invalidateScene();
+    stereoMode = mode;
+    Geometry::viewCount = (StereoMode::SINGLE_PASS == mode) ? 2 : 1;
+    submitNanos = 0;
+    submitFrames = 0;
+  }
+
+  void toggleStereoMode() {
+    setStereoMode(StereoMode::PER_EYE == stereoMode ?
+      StereoMode::SINGLE_PASS : StereoMode::PER_EYE);
+  }
+
+  void setMultires(bool enabled, const MultiresConfig & config = MultiresConfig()) {
+    invalidateScene();
+    multiresEnabled = enabled;
+    if (enabled && !multires) {
+      multires.reset(new Multires(frameBufferSize));
+    }
+    if (multires) {
+      multires->setConfig(config);
+    }
+  }
+
+  void toggleMultires() {
+    setMultires(!multiresEnabled, multires ? multires->getConfig() : MultiresConfig());
+    if (!multiresEnabled) {
+      SAY("Multi-resolution rendering disabled");
+      return;
+    }
+    const PerEyeArgs & eyeArgs = eyesArgs[ovrEye_Left];
+    Multires::EyeLayout layout = multires->layout(eyeArgs.projection,
+      eyeArgs.viewportPosition, eyeArgs.viewportSize);
+    SAY("Multi-resolution rendering enabled, shading %.0f%% of each eye's pixels%s",
+      100.0f * layout.shadedPixels / layout.eyePixels,
+      StereoMode::SINGLE_PASS == stereoMode ? " once back in per eye stereo" : "");
+  }
+
+  // The fraction of the eye pixels the last frame shaded
+  float getShadedFraction() const {
+    bool active = multiresEnabled && StereoMode::PER_EYE == stereoMode;
+    return active ? multires->getShadedFraction() : 1.0f;
+  }
+
   void drawFrame() {
-    static int frameIndex = 0;
-    ovrHmd_BeginFrame(hmd, frameIndex++);
+    Profiler::Zone zone("drawFrame");
+    int64_t start = Platform::elapsedNanos();
+    if (multiresEnabled) {
+      multires->beginFrame();
+    }
+
+    fbo.Bind(oglplus::Framebuffer::Target::Draw);
+    if (StereoMode::SINGLE_PASS == stereoMode) {
+      drawSinglePass(renderPoses);
+    } else {
+      drawPerEye(renderPoses);
+    }
+    oglplus::DefaultFramebuffer().Bind(oglplus::Framebuffer::Target::Draw);
+    GL_CHECK_ERROR;
+    reportSubmitTime(Platform::elapsedNanos() - start);
+  }
+
+  void endFrame() {
+    {
+      Profiler::Zone zone("ovrHmd_EndFrame");
+      ovrHmd_EndFrame(hmd, renderPoses, ovrTextures);
+    }
+    GL_CHECK_ERROR;
+    if (0 == frameIndex++) {
+      SAY("Time to first frame %.1f ms", (double)Platform::elapsedNanos() / 1e6);
+    }
+  }
+
+  // Consumes the scene's changed flag, and returns true if the last frame
+  // rendered can stand in for this one
+  bool canReuseFrame() {
+    static const float MAX_ANGLE = 2.0f * DEGREES_TO_RADIANS;
+    // Timewarp only corrects orientation, so translation shows as parallax
+    // error on the board, a few tens of centimeters away
+    static const float MAX_DISTANCE = 0.002f;
+    // Bounds how stale the rest of the view can get
+    static const int MAX_REUSED_FRAMES = 75;
+    static const int REPORT_FRAMES = 600;
+
+    bool reuse = frameReuse && !sceneChanged && reusedFrames < MAX_REUSED_FRAMES;
+    sceneChanged = false;
+    for_each_eye([&](ovrEyeType eye){
+      if (!reuse) {
+        return;
+      }
+      mat4 view = getEyeView(eye, Stacks::modelview().top(), ovrHmd_GetEyePose(hmd, eye));
+      // The eye's motion since the frame was rendered
+      mat4 delta = view * glm::inverse(renderedViews[eye]);
+      float cosAngle = (delta[0][0] + delta[1][1] + delta[2][2] - 1.0f) / 2.0f;
+      float angle = acos(glm::clamp(cosAngle, -1.0f, 1.0f));
+      if (angle > MAX_ANGLE || glm::length(vec3(delta[3])) > MAX_DISTANCE) {
+        reuse = false;
+      }
+    });
+    reusedFrames = reuse ? reusedFrames + 1 : 0;
+
+    if (frameReuse) {
+      reportReused += reuse ? 1 : 0;
+      if (++reportFrames == REPORT_FRAMES) {
+        SAY("Reused %d of the last %d frames", reportReused, reportFrames);
+        reportFrames = 0;
+        reportReused = 0;
+      }
+    }
+    return reuse;
+  }
+
+  void setResolutionScale(float scale) {
+    static const float MIN_RESOLUTION_SCALE = 0.5f;
+    scale = glm::clamp(scale, MIN_RESOLUTION_SCALE, 1.0f);
+    uvec2 eyeSize = glm::max(uvec2(vec2(maxEyeSize) * scale + 0.5f), uvec2(1));
+    resolutionScale = scale;
+    if (eyeSize == eyesArgs[ovrEye_Left].viewportSize) {
+      return;
+    }
+    invalidateScene();
+    for_each_eye([&](ovrEyeType eye){
+      PerEyeArgs & eyeArgs = eyesArgs[eye];
+      eyeArgs.viewportPosition = ivec2(ovrEye_Left == eye ? 0 : eyeSize.x, 0);
+      eyeArgs.viewportSize = eyeSize;
+      ovrTextureHeader & header = ovrTextures[eye].Header;
+      header.RenderViewport.Pos.x = eyeArgs.viewportPosition.x;
+      header.RenderViewport.Pos.y = eyeArgs.viewportPosition.y;
+      header.RenderViewport.Size = Rift::toOvr(eyeSize);
+    });
+  }
+
+  // Scales the eye viewports from the GPU time of earlier frames.  Over
+  // HIGH_WATER of the budget the scale drops at once to what should land
+  // on TARGET, since pixel cost goes with its square.  Under LOW_WATER it
+  // only rises after UPSCALE_FRAMES in a row, and by at most UPSCALE_STEP.
+  // The timings arrive GpuTimer::RING_FRAMES late, so after any change
+  // the scale holds until frames rendered at the new size are measured.
+  void adaptResolution() {
+    // The DK2 refreshes at 75Hz
+    static const float BUDGET_MS = 1000.0f / 75.0f;
+    static const float HIGH_WATER = 0.9f;
+    static const float TARGET = 0.8f;
+    static const float LOW_WATER = 0.65f;
+    static const int UPSCALE_FRAMES = 45;
+    static const float UPSCALE_STEP = 0.05f;
+
+    float millis;
+    if (!adaptiveResolution || !GpuTimer::getLatest("Frame", millis)) {
+      return;
+    }
+    // A reused frame's timing says nothing about the cost of rendering
+    if (reusedHistory[frameIndex % GpuTimer::RING_FRAMES]) {
+      return;
+    }
+    if (settleFrames > 0) {
+      --settleFrames;
+      return;
+    }
+    float scale = resolutionScale;
+    float ideal = scale * sqrt(BUDGET_MS * TARGET / millis);
+    if (millis > BUDGET_MS * HIGH_WATER) {
+      scale = ideal;
+    } else if (millis < BUDGET_MS * LOW_WATER && scale < 1.0f) {
+      if (++fastFrames < UPSCALE_FRAMES) {
+        return;
+      }
+      scale = std::min(ideal, scale + UPSCALE_STEP);
+    } else {
+      fastFrames = 0;
+      return;
+    }
+    fastFrames = 0;
+    uvec2 oldSize = eyesArgs[ovrEye_Left].viewportSize;
+    setResolutionScale(scale);
+    if (oldSize != eyesArgs[ovrEye_Left].viewportSize) {
+      settleFrames = GpuTimer::RING_FRAMES;
+      SAY("Eye resolution %dx%d (%.0f%%), frame took %.2f ms on the GPU",
+        eyesArgs[ovrEye_Left].viewportSize.x, eyesArgs[ovrEye_Left].viewportSize.y,
+        resolutionScale * 100.0f, millis);
+    }
+  }
+
+private:
+  // The view for an eye, given the app's base view and the eye's pose
+  mat4 getEyeView(ovrEyeType eye, const mat4 & baseView, const ovrPosef & pose) {
+    return eyesArgs[eye].viewAdjust *
+      glm::inverse(Rift::fromOvr(pose)) * baseView;
+  }
+
+  // Renders the whole scene once for each eye
+  void drawPerEye(ovrPosef * renderPoses) {
     MatrixStack & mv = Stacks::modelview();
     MatrixStack & pr = Stacks::projection();
-    static ovrPosef renderPoses[2];
+    // drawScene clears the whole framebuffer, so confine it to the eye
+    glEnable(GL_SCISSOR_TEST);
     for (int i = 0; i < 2; ++i) {
       ovrEyeType eye = currentEye = hmd->EyeRenderOrder[i];
+      bool left = (ovrEye_Left == eye);
+      GpuTimer::Scope timer(multiresEnabled ?
+        (left ? "Left MRS" : "Right MRS") : (left ? "Left eye" : "Right eye"));
       PerEyeArgs & eyeArgs = eyesArgs[eye];
+      // Set up the per-eye projection matrix
       pr.top() = eyeArgs.projection;
       Stacks::with_push(pr, mv, [&]{
-        // Set up the per-eye projection matrix
         renderPoses[eye] = ovrHmd_GetEyePose(hmd, eye);
-
-        // Apply the head pose
-        mv.preMultiply(glm::inverse(Rift::fromOvr(renderPoses[eye])));
-
-        // Apply the per-eye offset
-        mv.preMultiply(eyeArgs.viewAdjust);
-
-        //frameBuffers[eye].activate();
-        eyeArgs.fbo.Bind(oglplus::Framebuffer::Target::Draw);
-        gl.Viewport(0, 0, ovrTextures[eye].Header.TextureSize.w,
-          ovrTextures[eye].Header.TextureSize.h);
+        mv.top() = getEyeView(eye, mv.top(), renderPoses[eye]);
+        renderedViews[eye] = mv.top();
+        if (multiresEnabled) {
+          // Each region is drawn as a camera of its own
+          multires->renderEye(eyeArgs.projection, eyeArgs.viewportPosition,
+              eyeArgs.viewportSize, fbo, [&](const mat4 & projection){
+            pr.top() = projection;
+            Uniforms::setCamera(projection, mv.top());
+            Culling::setViews(&projection, 1);
+            drawScene();
+          });
+          return;
+        }
+        Uniforms::setCamera(pr.top(), mv.top());
+        Culling::setViews(&pr.top(), 1);
+
+        gl.Viewport(eyeArgs.viewportPosition.x, eyeArgs.viewportPosition.y,
+          eyeArgs.viewportSize.x, eyeArgs.viewportSize.y);
+        glScissor(eyeArgs.viewportPosition.x, eyeArgs.viewportPosition.y,
+          eyeArgs.viewportSize.x, eyeArgs.viewportSize.y);
         // Render the scene to an offscreen buffer
         drawScene();
-        oglplus::DefaultFramebuffer().Bind(oglplus::Framebuffer::Target::Draw);
       });
       GL_CHECK_ERROR;
     }
+    glDisable(GL_SCISSOR_TEST);
+    currentEye = ovrEye_Count;
+  }
 
-    ovrHmd_EndFrame(hmd, renderPoses, ovrTextures);
-    GL_CHECK_ERROR;
+  // Renders both eyes with one pass over the scene.  Every draw is
+  // instanced twice, and the vertex shaders route odd instances to the
+  // right eye (see shaders/Stereo.glsl).
+  void drawSinglePass(ovrPosef * renderPoses) {
+    GpuTimer::Scope timer("Both eyes");
+    MatrixStack & mv = Stacks::modelview();
+    MatrixStack & pr = Stacks::projection();
+    mat4 projections[2];
+    mat4 views[2];
+    for_each_eye([&](ovrEyeType eye){
+      renderPoses[eye] = ovrHmd_GetEyePose(hmd, eye);
+      projections[eye] = eyesArgs[eye].projection;
+      views[eye] = getEyeView(eye, mv.top(), renderPoses[eye]);
+      renderedViews[eye] = views[eye];
+    });
+
+    pr.top() = projections[ovrEye_Left];
+    Stacks::with_push(pr, mv, [&]{
+      mv.top() = views[ovrEye_Left];
+      Uniforms::setStereoCamera(projections, views);
+      // The scene is drawn from the left eye's view, so the right eye's
+      // frustum is offset from it
+      mat4 clips[2] = {
+        projections[ovrEye_Left],
+        projections[ovrEye_Right] * views[ovrEye_Right] * glm::inverse(views[ovrEye_Left])
+      };
+      Culling::setViews(clips, 2);
+      // Both eyes' viewports, side by side
+      const PerEyeArgs & right = eyesArgs[ovrEye_Right];
+      gl.Viewport(0, 0, right.viewportPosition.x + right.viewportSize.x, right.viewportSize.y);
+      glEnable(GL_CLIP_DISTANCE0);
+      drawScene();
+      glDisable(GL_CLIP_DISTANCE0);
+    });
+  }
+
+  void reportSubmitTime(int64_t nanos) {
+    static const int REPORT_FRAMES = 600;
+    submitNanos += nanos;
+    if (++submitFrames == REPORT_FRAMES) {
+      SAY("%s stereo: %.3f ms CPU submit per frame",
+        StereoMode::SINGLE_PASS == stereoMode ? "Single pass" : "Per eye",
+        (double)submitNanos / submitFrames / 1000000.0);
+      submitNanos = 0;
+      submitFrames = 0;
+    }
   }
 };
 
@@ -347,6 +690,9 @@ public:
 // to launch a class containing a run method
 #define RUN_OVR_APP(AppClass) \
 MAIN_DECL { \
+  /* Starts the clock that time to first frame is measured against */ \
+  Platform::elapsedNanos(); \
+  Profiler::setThreadName("Main"); \
   if (!ovr_Initialize()) { \
       SAY_ERR("Failed to initialize the Oculus SDK"); \
       return -1; \
@@ -0,0 +1,97 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+// In GL_TEXTURE_CUBE_MAP_POSITIVE_X order.  The up vectors follow the
+// cubemap convention of each face's t axis pointing down.
+static const vec3 FACE_DIRECTIONS[6] = {
+  vec3(1, 0, 0), vec3(-1, 0, 0),
+  vec3(0, 1, 0), vec3(0, -1, 0),
+  vec3(0, 0, 1), vec3(0, 0, -1),
+};
+
+static const vec3 FACE_UPS[6] = {
+  vec3(0, -1, 0), vec3(0, -1, 0),
+  vec3(0, 0, 1), vec3(0, 0, -1),
+  vec3(0, -1, 0), vec3(0, -1, 0),
+};
+
+SkyboxCache::SkyboxCache(Resource fragmentShader, int size, int facesPerFrame) :
+  program(GlUtils::getProgramHandle(Resource::SHADERS_CUBEMAP_VS, fragmentShader)),
+  size(size), facesPerFrame(std::max(1, std::min(6, facesPerFrame)))
+{
+  Context & gl = GlUtils::context();
+  // Filter across face edges, or they show at low resolutions
+  glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
+  for (int i = 0; i < 2; ++i) {
+    auto textureBinding = gl.Bound(Texture::Target::CubeMap, textures[i]);
+    textureBinding
+      .MinFilter(TextureMinFilter::Linear)
+      .MagFilter(TextureMagFilter::Linear)
+      .WrapS(TextureWrap::ClampToEdge)
+      .WrapT(TextureWrap::ClampToEdge)
+      .WrapR(TextureWrap::ClampToEdge);
+    for (int face = 0; face < 6; ++face) {
+      glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA8,
+        size, size, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    }
+  }
+  GL_CHECK_ERROR;
+  SAY("Caching the sky in %dx%d cubemaps, %d face(s) per frame",
+    size, size, this->facesPerFrame);
+}
+
+bool SkyboxCache::update() {
+  GpuTimer::Scope timer("Skybox faces");
+  Context & gl = GlUtils::context();
+  MatrixStack & mv = Stacks::modelview();
+  MatrixStack & pr = Stacks::projection();
+
+  // The faces are single views, even when the eyes are drawn in one pass
+  int viewCount = Geometry::viewCount;
+  Geometry::viewCount = 1;
+  int viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  fbo.Bind(Framebuffer::Target::Draw);
+  gl.Viewport(size, size);
+  // The skybox shaders colour a pixel by -Position, so the cube is
+  // mirrored to make each texel hold the sky in its own direction.
+  // Mirroring reverses the winding.
+  gl.FrontFace(FaceOrientation::CW);
+
+  int faces = primed ? facesPerFrame : 6;
+  bool swapped = false;
+  Stacks::with_push(pr, mv, [&]{
+    pr.top() = glm::perspective(PI / 2.0f, 1.0f, 0.01f, 10.0f);
+    for (int i = 0; i < faces; ++i) {
+      if (0 == nextFace) {
+        cycleTime = Platform::elapsedMillis() / 1000.0f;
+      }
+      glFramebufferTexture2D(GL_DRAW_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+        GL_TEXTURE_CUBE_MAP_POSITIVE_X + nextFace, GetName(textures[1 - front]), 0);
+      mat4 view = glm::lookAt(vec3(0), FACE_DIRECTIONS[nextFace], FACE_UPS[nextFace]);
+      Uniforms::setCamera(pr.top(), view);
+      mv.top() = glm::scale(view, vec3(-1));
+      Render::renderProceduralSkybox(program, cycleTime);
+      if (6 == ++nextFace) {
+        // Start the next cycle on the next frame, with a fresh time
+        nextFace = 0;
+        front = 1 - front;
+        primed = true;
+        swapped = true;
+        break;
+      }
+    }
+  });
+
+  gl.FrontFace(FaceOrientation::CCW);
+  DefaultFramebuffer().Bind(Framebuffer::Target::Draw);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  Geometry::viewCount = viewCount;
+  GL_CHECK_ERROR;
+  return swapped;
+}
+
+void SkyboxCache::render() {
+  Render::renderSkybox(textures[front]);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+// Renders a procedural sky shader into a cubemap, so the eye passes only
+// sample a texture rather than evaluating the noise for every pixel.
+//
+// The faces are rendered facesPerFrame at a time into a back cubemap, all
+// with the time at which the cycle started, and the cubemaps are swapped
+// once all six are done.  The sky shown therefore animates at a rate of
+// one step every 6 / facesPerFrame frames, but never has seams between
+// faces rendered at different times.
+class SkyboxCache {
+public:
+  static const int DEFAULT_SIZE = 512;
+  static const int DEFAULT_FACES_PER_FRAME = 1;
+
+private:
+  ProgramHandle         program;
+  int                   size;
+  int                   facesPerFrame;
+  oglplus::Texture      textures[2];
+  oglplus::Framebuffer  fbo;
+  // Index of the texture being shown, the other is being rendered
+  int                   front{ 0 };
+  int                   nextFace{ 0 };
+  float                 cycleTime{ 0 };
+  // Whether a complete cubemap has been rendered yet
+  bool                  primed{ false };
+
+public:
+  SkyboxCache(Resource fragmentShader,
+    int size = DEFAULT_SIZE,
+    int facesPerFrame = DEFAULT_FACES_PER_FRAME);
+
+  // Renders the next faces.  Call once per frame, outside the eye passes;
+  // it changes the camera uniforms and leaves the default framebuffer
+  // bound, but restores the viewport.  The first call renders all six
+  // faces.  Returns true when the cubemap shown changed.
+  bool update();
+
+  // Draws the sky for the current camera
+  void render();
+};
@@ -24,7 +24,10 @@ private:
 public:
 
   SocketClient() :
-    work(io_service), serviceThread(boost::bind(&boost::asio::io_service::run, &io_service)), socket(io_service) {
+    work(io_service), serviceThread([this]{
+      Profiler::setThreadName("Network");
+      io_service.run();
+    }), socket(io_service) {
   }
 
   void write(const char msg) {
@@ -35,6 +38,12 @@ public:
     io_service.post(boost::bind(&SocketClient::doWriteString, this, msg));
   }
 
+  // Unlike write(), this sends without waiting for the queued handlers
+  // when called from the I/O thread itself
+  void writeNow(const std::string msg) {
+    io_service.dispatch(boost::bind(&SocketClient::doWriteString, this, msg));
+  }
+
   void close() // call the do_close function via the io service in the other thread
   {
     io_service.post(boost::bind(&SocketClient::doClose, this));
@@ -77,6 +86,7 @@ private:
   }
 
   void readComplete(const boost::system::error_code& error, size_t bytes_transferred) {
+    Profiler::Zone zone("readComplete");
     if (error) {
       doClose();
       return;
@@ -0,0 +1,43 @@
+#pragma once
+
+// Hands the newest value from one producer thread to one consumer thread
+// without locks.  The producer fills writeBuffer() and publishes it, the
+// consumer takes whatever was published last.  Neither side ever waits on
+// the other, and values published in between are skipped rather than
+// queued.
+//
+//   // Producer                       // Consumer
+//   buffer.writeBuffer() = state;     const State & state = buffer.consume();
+//   buffer.publish();
+template <typename T>
+class TripleBuffer {
+  // Set in the shared index when it holds a value the consumer hasn't seen
+  static const int FRESH = 4;
+
+  T slots[3];
+  std::atomic<int> middle{ 1 };
+  // Only touched by the producer
+  int back{ 0 };
+  // Only touched by the consumer
+  int front{ 2 };
+
+public:
+  // Slot the producer writes into.  Its previous contents are stale, but
+  // whatever it allocated is kept, so copying into it doesn't allocate
+  // once it has grown.
+  T & writeBuffer() {
+    return slots[back];
+  }
+
+  void publish() {
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & ~FRESH;
+  }
+
+  // Newest published value.  Stays valid until the next consume().
+  const T & consume() {
+    if (middle.load(std::memory_order_relaxed) & FRESH) {
+      front = middle.exchange(front, std::memory_order_acq_rel) & ~FRESH;
+    }
+    return slots[front];
+  }
+};
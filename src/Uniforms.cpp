@@ -0,0 +1,110 @@
+#include "Common.h"
+
+using namespace oglplus;
+
+// Enough for several thousand draws per frame
+static const GLsizeiptr REGION_SIZE = 1 << 20;
+static const int REGIONS = 3;
+
+struct UniformRing {
+  oglplus::Buffer buffer;
+  uint8_t *       data{ nullptr };
+  GLsync          fences[REGIONS];
+  GLint           alignment{ 256 };
+  int             region{ 0 };
+  GLintptr        offset{ 0 };
+
+  UniformRing() {
+    static const GLbitfield FLAGS =
+      GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    memset(fences, 0, sizeof(fences));
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    buffer.Bind(Buffer::Target::Uniform);
+    glBufferStorage(GL_UNIFORM_BUFFER, REGION_SIZE * REGIONS, nullptr, FLAGS);
+    data = (uint8_t*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, REGION_SIZE * REGIONS, FLAGS);
+    NoBuffer().Bind(Buffer::Target::Uniform);
+    if (!data) {
+      FAIL("Unable to map the uniform ring buffer");
+    }
+  }
+
+  void nextRegion() {
+    if (fences[region]) {
+      glDeleteSync(fences[region]);
+    }
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % REGIONS;
+    offset = 0;
+    if (fences[region]) {
+      GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+      while (GL_TIMEOUT_EXPIRED == result) {
+        result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+      }
+      glDeleteSync(fences[region]);
+      fences[region] = 0;
+    }
+  }
+
+  void write(GLuint binding, const void * block, GLsizeiptr size) {
+    offset = (offset + alignment - 1) / alignment * alignment;
+    if (offset + size > REGION_SIZE) {
+      // Every block in the region may still be in use, so the only safe
+      // way to reuse it is to wait for the GPU
+      static bool warned = false;
+      if (!warned) {
+        warned = true;
+        SAY("Uniform ring region full, stalling.  Consider raising REGION_SIZE.");
+      }
+      glFinish();
+      offset = 0;
+    }
+    GLintptr start = REGION_SIZE * region + offset;
+    memcpy(data + start, block, size);
+    glBindBufferRange(GL_UNIFORM_BUFFER, binding, GetName(buffer), start, size);
+    offset += size;
+  }
+};
+
+static UniformRing & ring() {
+  static UniformRing ring;
+  return ring;
+}
+
+void Uniforms::beginFrame() {
+  ring().nextRegion();
+}
+
+void Uniforms::setCamera(const mat4 & projection, const mat4 & view) {
+  CameraBlock camera;
+  camera.projection = projection;
+  camera.view = view;
+  ring().write(Layout::UniformBlock::Camera, &camera, sizeof(camera));
+}
+
+void Uniforms::setStereoCamera(const mat4 projections[2], const mat4 views[2]) {
+  CameraBlock camera;
+  camera.projection = projections[0];
+  camera.view = views[0];
+  camera.stereo = 1;
+  mat4 inverseLeft = glm::inverse(views[0]);
+  for (int eye = 0; eye < 2; ++eye) {
+    camera.eyeProjection[eye] = projections[eye];
+    camera.eyeOffset[eye] = views[eye] * inverseLeft;
+  }
+  ring().write(Layout::UniformBlock::Camera, &camera, sizeof(camera));
+}
+
+void Uniforms::setLights(const Lights & lights) {
+  LightingBlock lighting;
+  lighting.ambient = lights.ambient;
+  lighting.count = std::min<int>(lights.lightPositions.size(), LightingBlock::MAX_LIGHTS);
+  for (int i = 0; i < lighting.count; ++i) {
+    lighting.positions[i] = vec4(lights.lightPositions[i], 1);
+    lighting.colors[i] = lights.lightColors[i];
+  }
+  ring().write(Layout::UniformBlock::Lighting, &lighting, sizeof(lighting));
+}
+
+void Uniforms::setDraw(const DrawBlock & draw) {
+  ring().write(Layout::UniformBlock::Draw, &draw, sizeof(draw));
+}
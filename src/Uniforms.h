@@ -0,0 +1,63 @@
+#pragma once
+
+// std140 mirrors of the uniform blocks in shaders/Uniforms.glsl
+
+struct CameraBlock {
+  mat4  projection;
+  mat4  view;
+  mat4  eyeProjection[2];
+  mat4  eyeOffset[2];
+  GLint stereo{ 0 };
+  GLint padding[3];
+};
+
+struct LightingBlock {
+  static const int MAX_LIGHTS = 8;
+
+  vec4  ambient;
+  vec4  positions[MAX_LIGHTS];
+  vec4  colors[MAX_LIGHTS];
+  GLint count{ 0 };
+  GLint padding[3];
+};
+
+struct DrawBlock {
+  mat4    modelView;
+  vec4    color{ 1 };
+  // A GLSL bool is 4 bytes in std140
+  GLint   instanceTransformActive{ 0 };
+  GLfloat forceAlpha{ 0 };
+  GLint   padding[2];
+
+  DrawBlock(const mat4 & modelView = mat4()) : modelView(modelView) {
+  }
+};
+
+// Writes the shared uniform blocks into a persistently mapped ring buffer
+// and binds them to their Layout::UniformBlock binding points.  Every
+// program includes the same block declarations with explicit bindings,
+// so nothing needs to be set per program.
+//
+// The ring is split into one region per frame in flight, so a block that
+// has been written is never overwritten until the GPU is done with it.
+class Uniforms {
+private:
+  Uniforms() {}
+
+public:
+  // Call once per frame before writing any blocks
+  static void beginFrame();
+  // Call once per eye
+  static void setCamera(const mat4 & projection, const mat4 & view);
+  // Call once per frame for single pass stereo, in place of setCamera.
+  // ModelView matrices are expected to be built on the left eye's view.
+  static void setStereoCamera(const mat4 projections[2], const mat4 views[2]);
+  // Call once per eye (or frame), after the camera
+  static void setLights(const Lights & lights);
+  // Call before every draw
+  static void setDraw(const DrawBlock & draw);
+
+  static void setDraw() {
+    setDraw(DrawBlock(Stacks::modelview().top()));
+  }
+};
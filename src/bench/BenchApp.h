@@ -0,0 +1,65 @@
+#pragma once
+
+// Runs a benchmark class against a hidden window's GL 4.4 core context,
+// rendering into its own framebuffer so nothing is ever presented.
+template <class T>
+class BenchWrapperApp : public SdlWrapperApp<T, uvec2> {
+  typedef SdlWrapperApp<T, uvec2> Super;
+
+public:
+  BenchWrapperApp() {
+    Super::windowSize = uvec2(1280, 800);
+    Super::windowPosition = ivec2(0, 0);
+  }
+
+  virtual SDL_Window * createWindow() {
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 4);
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+    SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
+    SDL_Window * result = SDL_CreateWindow("Benchmark",
+      Super::windowPosition.x, Super::windowPosition.y,
+      Super::windowSize.x, Super::windowSize.y,
+      SDL_WINDOW_OPENGL | SDL_WINDOW_HIDDEN);
+    if (!result) {
+      FAIL("Unable to create the benchmark window: %s", SDL_GetError());
+    }
+    return result;
+  }
+
+  virtual uvec2 getArgs() {
+    return Super::windowSize;
+  }
+};
+
+// A color and depth target the size of one eye
+struct BenchFramebuffer {
+  oglplus::Texture      color;
+  oglplus::Renderbuffer depth;
+  oglplus::Framebuffer  fbo;
+  uvec2                 size;
+
+  BenchFramebuffer(const uvec2 & size) : size(size) {
+    using namespace oglplus;
+    Context gl;
+    gl.Bound(Texture::Target::_2D, color)
+      .MinFilter(TextureMinFilter::Linear)
+      .MagFilter(TextureMagFilter::Linear)
+      .Image2D(0, PixelDataInternalFormat::RGBA8,
+      size.x, size.y,
+      0, PixelDataFormat::RGB, PixelDataType::UnsignedByte, nullptr
+      );
+    gl.Bound(Renderbuffer::Target::Renderbuffer, depth)
+      .Storage(PixelDataInternalFormat::DepthComponent, size.x, size.y);
+    gl.Bound(Framebuffer::Target::Draw, fbo)
+      .AttachTexture(FramebufferAttachment::Color, color, 0)
+      .AttachRenderbuffer(FramebufferAttachment::Depth, depth)
+      .Complete();
+  }
+
+  void bind() {
+    using namespace oglplus;
+    fbo.Bind(Framebuffer::Target::Draw);
+    Context().Viewport(size.x, size.y);
+  }
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+// Public in non-MX builds of GLEW, just not declared.  glewInit would go
+// on to initialize GLX, which needs an X display.
+extern "C" GLenum GLEWAPIENTRY glewContextInit(void);
+
+// Runs a benchmark class against an EGL GL 4.4 core context with no
+// window, for build machines with no display (Mesa's llvmpipe will do).
+// The context is surfaceless where EGL_KHR_surfaceless_context is
+// supported, and otherwise current on a 1x1 pbuffer; either way the
+// benchmark renders into its own framebuffers.
+template <class T>
+class EglWrapperApp {
+  EGLDisplay  display{ EGL_NO_DISPLAY };
+  EGLContext  context{ EGL_NO_CONTEXT };
+  EGLSurface  surface{ EGL_NO_SURFACE };
+  uvec2       size;
+
+public:
+  EglWrapperApp(const uvec2 & size = uvec2(1280, 800)) : size(size) {
+  }
+
+  virtual ~EglWrapperApp() {
+    if (EGL_NO_DISPLAY == display) {
+      return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (EGL_NO_SURFACE != surface) {
+      eglDestroySurface(display, surface);
+    }
+    if (EGL_NO_CONTEXT != context) {
+      eglDestroyContext(display, context);
+    }
+    eglTerminate(display);
+  }
+
+  virtual int run() {
+    createContext();
+    glewExperimental = true;
+    if (GLEW_OK != glewContextInit()) {
+      FAIL("Unable to load the GL entry points");
+    }
+    // GLEW probes with calls that are errors in a core context
+    glGetError();
+    SAY("Renderer: %s, %s", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+
+    T wrapped(size);
+    while (!wrapped.isDone()) {
+      wrapped.onTick();
+    }
+    return 0;
+  }
+
+private:
+  static bool hasExtension(const char * extensions, const char * name) {
+    if (!extensions) {
+      return false;
+    }
+    size_t length = strlen(name);
+    for (const char * found = strstr(extensions, name); found; found = strstr(found + length, name)) {
+      // Make sure it isn't just a prefix of a longer name
+      if ((found == extensions || ' ' == found[-1]) &&
+          (' ' == found[length] || 0 == found[length])) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Prefers Mesa's surfaceless platform, which needs no window system at
+  // all, over the default display
+  static EGLDisplay getDisplay() {
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+    const char * clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+      PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+        eglGetProcAddress("eglGetPlatformDisplayEXT");
+      if (getPlatformDisplay) {
+        EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (EGL_NO_DISPLAY != display) {
+          return display;
+        }
+      }
+    }
+#endif
+    return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  }
+
+  void createContext() {
+    display = getDisplay();
+    if (EGL_NO_DISPLAY == display || !eglInitialize(display, nullptr, nullptr)) {
+      FAIL("Unable to initialize EGL: 0x%x", eglGetError());
+    }
+    if (!eglBindAPI(EGL_OPENGL_API)) {
+      FAIL("EGL has no desktop GL support: 0x%x", eglGetError());
+    }
+    bool surfaceless = hasExtension(eglQueryString(display, EGL_EXTENSIONS),
+      "EGL_KHR_surfaceless_context");
+
+    const EGLint configAttributes[] = {
+      // Surfaceless contexts don't care what surfaces the config supports
+      EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttributes, &config, 1, &configCount) || !configCount) {
+      FAIL("No suitable EGL config: 0x%x", eglGetError());
+    }
+
+    static const EGLint CONTEXT_ATTRIBUTES[] = {
+      EGL_CONTEXT_MAJOR_VERSION_KHR, 4,
+      EGL_CONTEXT_MINOR_VERSION_KHR, 4,
+      EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+      EGL_NONE
+    };
+    context = eglCreateContext(display, config, EGL_NO_CONTEXT, CONTEXT_ATTRIBUTES);
+    if (EGL_NO_CONTEXT == context) {
+      FAIL("Unable to create a GL 4.4 core context: 0x%x", eglGetError());
+    }
+
+    if (!surfaceless) {
+      static const EGLint PBUFFER_ATTRIBUTES[] = {
+        EGL_WIDTH, 1,
+        EGL_HEIGHT, 1,
+        EGL_NONE
+      };
+      surface = eglCreatePbufferSurface(display, config, PBUFFER_ATTRIBUTES);
+      if (EGL_NO_SURFACE == surface) {
+        FAIL("Unable to create a pbuffer: 0x%x", eglGetError());
+      }
+    }
+    if (!eglMakeCurrent(display, surface, surface, context)) {
+      FAIL("Unable to make the EGL context current: 0x%x", eglGetError());
+    }
+  }
+};
@@ -0,0 +1,101 @@
+#include "Common.h"
+#include "bench/BenchApp.h"
+
+#pragma warning( disable : 4068 4244 4099 4305 4101)
+#include <oglplus/bound/texture.hpp>
+#include <oglplus/bound/framebuffer.hpp>
+#include <oglplus/bound/renderbuffer.hpp>
+#pragma warning( default : 4068 4244 4099 4305 4101)
+
+using namespace oglplus;
+
+// Reports the vertex memory and vertex throughput of the piece meshes in
+// the original all-vec4 layout against the packed layout.  Drawing goes to
+// a tiny target so the timings are dominated by vertex work.
+class VertexBench {
+  static const int DRAWS = 2000;
+
+  BenchFramebuffer framebuffer{ uvec2(64, 64) };
+  Lights lights;
+  bool done{ false };
+
+public:
+  VertexBench(const uvec2 &) {
+    Stacks::projection().top() = glm::perspective(PI / 2.0f, 1.0f, 0.01f, 100.0f);
+    Stacks::modelview().top() = glm::lookAt(vec3(0, 0.1, 0.3), vec3(0), GlUtils::Y_AXIS);
+    glEnable(GL_DEPTH_TEST);
+  }
+
+  bool isDone() {
+    return done;
+  }
+
+  // Returns GPU nanoseconds for DRAWS draws of the geometry
+  GLuint64 timeDraws(Geometry & geometry) {
+    Program & prog = GlUtils::getProgram(
+      Resource::SHADERS_LITCOLORED_VS,
+      Resource::SHADERS_LITCOLORED_FS);
+    GLuint query;
+    glGenQueries(1, &query);
+
+    Uniforms::beginFrame();
+    Uniforms::setCamera(Stacks::projection().top(), Stacks::modelview().top());
+    Uniforms::setLights(lights);
+    prog.Use();
+    Uniforms::setDraw(DrawBlock(glm::scale(mat4(), vec3(GlUtils::CHESS_SCALE * 1.6f))));
+    geometry.bind();
+    // Warm up, then time
+    geometry.draw();
+    glFinish();
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    for (int i = 0; i < DRAWS; ++i) {
+      geometry.draw();
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+    NoVertexArray().Bind();
+    NoProgram().Use();
+
+    GLuint64 result = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &result);
+    glDeleteQueries(1, &query);
+    return result;
+  }
+
+  void onTick() {
+    framebuffer.bind();
+    size_t totalUnpacked = 0, totalPacked = 0;
+    SAY("mesh, vertices, vec4 bytes, packed bytes, memory ratio, vec4 Mverts/s, packed Mverts/s, vec4 GB/s, packed GB/s");
+    for (int type = 0; type < Chess::PieceType::COUNT; ++type) {
+      Resource resource = GlUtils::PIECE_RESOURCES[type];
+      Mesh mesh;
+      GlUtils::loadCtmMesh(resource, mesh);
+      Geometry unpacked, packed;
+      unpacked.loadMesh(mesh, false);
+      packed.loadMesh(mesh, true);
+      totalUnpacked += unpacked.vertexBytes;
+      totalPacked += packed.vertexBytes;
+
+      // Vertices processed, counting each index, since that's what gets
+      // fetched when the post transform cache misses
+      double verts = (double)mesh.indices.size() * DRAWS;
+      double unpackedSeconds = timeDraws(unpacked) / 1e9;
+      double packedSeconds = timeDraws(packed) / 1e9;
+      double bytes = (double)unpacked.vertexBytes * DRAWS;
+      double packedBytes = (double)packed.vertexBytes * DRAWS;
+      SAY("%s, %d, %d, %d, %.2f, %.1f, %.1f, %.2f, %.2f",
+        Platform::getResourcePath(resource).c_str(),
+        (int)mesh.positions.size(),
+        (int)unpacked.vertexBytes, (int)packed.vertexBytes,
+        (double)unpacked.vertexBytes / packed.vertexBytes,
+        verts / unpackedSeconds / 1e6, verts / packedSeconds / 1e6,
+        bytes / unpackedSeconds / 1e9, packedBytes / packedSeconds / 1e9);
+    }
+    SAY("all pieces, vertex memory %d -> %d bytes, %.2fx smaller",
+      (int)totalUnpacked, (int)totalPacked, (double)totalUnpacked / totalPacked);
+    SAY("shared mesh buffer, %d bytes", (int)GlUtils::getSharedMeshes().vertexBytes);
+    DefaultFramebuffer().Bind(Framebuffer::Target::Draw);
+    done = true;
+  }
+};
+
+RUN_APP(BenchWrapperApp<VertexBench>);
@@ -0,0 +1,276 @@
+#include "Common.h"
+#include "bench/BenchApp.h"
+#include "bench/EglBenchApp.h"
+
+#pragma warning( disable : 4068 4244 4099 4305 4101)
+#include <oglplus/bound/texture.hpp>
+#include <oglplus/bound/framebuffer.hpp>
+#include <oglplus/bound/renderbuffer.hpp>
+#pragma warning( default : 4068 4244 4099 4305 4101)
+
+using namespace oglplus;
+
+// Matches the DK2's default eye buffers
+static const uvec2 EYE_SIZE(1182, 1464);
+static const uvec2 UI_SIZE(640, 480);
+
+// Renders scripted scenes the way VirtualChess does, through both stereo
+// paths, with a fake HMD in place of ovrHmd_Create, and reports for each
+// the CPU time to submit a frame, the GPU time to render it, and the draw
+// calls in it.  Needs no display, so it can run on build machines.
+class VirtualChessBench {
+  static const int WARMUP_FRAMES = 30;
+  static const int FRAMES = 300;
+  static const int WALL_BOARDS = 64;
+  // Each frame, one in this many boards gets a new move
+  static const int MOVE_RATE = 20;
+
+  struct Scene {
+    const char * name;
+    bool wall;
+    bool ui;
+  };
+
+  RiftApp::PerEyeArgs eyesArgs[2];
+  BenchFramebuffer framebuffer{ uvec2(EYE_SIZE.x * 2, EYE_SIZE.y) };
+  BenchFramebuffer uiFramebuffer{ UI_SIZE };
+  Geometry uiGeometry;
+  SkyboxCache skybox{ Resource::SHADERS_MOVINGTHROUGHSPEHERESPACE_FS };
+  PieceRenderer pieces;
+  BoardWall wall;
+  std::vector<Chess::Board> boards;
+  Lights lights;
+  mat4 baseView{ glm::lookAt(vec3(0, 0.25, 0.35), vec3(0, 0.25, 0), GlUtils::Y_AXIS) };
+  bool done{ false };
+
+public:
+  VirtualChessBench(const uvec2 &) {
+    for_each_eye([&](ovrEyeType eye){
+      eyesArgs[eye] = fakeEyeArgs(eye);
+    });
+
+    Gui::init(UI_SIZE);
+    CEGUI::WindowManager & wmgr = CEGUI::WindowManager::getSingleton();
+    CEGUI::FrameWindow * rootWindow = dynamic_cast<CEGUI::FrameWindow *>(
+      wmgr.createWindow("TaharezLook/FrameWindow", "root"));
+    rootWindow->setTitleBarEnabled(false);
+    rootWindow->setSize(CEGUI::USize(cegui_absdim(UI_SIZE.x), cegui_absdim(UI_SIZE.y)));
+    rootWindow->addChild(wmgr.loadLayoutFromFile("Login.layout"));
+    CEGUI::System::getSingleton().getDefaultGUIContext().setRootWindow(rootWindow);
+
+    Mesh uiMesh;
+    vec2 quadSize = vec2(UI_SIZE) / (float)std::max(UI_SIZE.x, UI_SIZE.y) * 0.8f;
+    uiMesh.addTexturedQuad(quadSize.x, quadSize.y);
+    uiGeometry.loadMesh(uiMesh);
+    glEnable(GL_BLEND);
+  }
+
+  bool isDone() {
+    return done;
+  }
+
+  // Roughly a DK2: a 64mm IPD and its default FOV, which is wider towards
+  // the outside of each eye
+  static RiftApp::PerEyeArgs fakeEyeArgs(ovrEyeType eye) {
+    static const float IPD = 0.064f;
+    static const float UP_TAN = 1.3292f, DOWN_TAN = 1.3292f;
+    static const float INNER_TAN = 1.0586f, OUTER_TAN = 1.0924f;
+    static const float NEAR_CLIP = 0.01f, FAR_CLIP = 100.0f;
+    bool left = (ovrEye_Left == eye);
+    RiftApp::PerEyeArgs result;
+    float leftTan = left ? OUTER_TAN : INNER_TAN;
+    float rightTan = left ? INNER_TAN : OUTER_TAN;
+    result.projection = glm::frustum(
+      -leftTan * NEAR_CLIP, rightTan * NEAR_CLIP,
+      -DOWN_TAN * NEAR_CLIP, UP_TAN * NEAR_CLIP,
+      NEAR_CLIP, FAR_CLIP);
+    result.viewAdjust = glm::translate(mat4(), vec3((left ? 1 : -1) * IPD / 2.0f, 0, 0));
+    result.viewportPosition = ivec2(left ? 0 : EYE_SIZE.x, 0);
+    result.viewportSize = EYE_SIZE;
+    return result;
+  }
+
+  // Moves a random piece to a random empty square, like WallBench
+  static void randomMove(Chess::Board & board) {
+    for (int tries = 0; tries < 64; ++tries) {
+      Chess::Piece & from = board.position[rand() % 8][rand() % 8];
+      Chess::Piece & to = board.position[rand() % 8][rand() % 8];
+      if (from && !to) {
+        std::swap(from, to);
+        return;
+      }
+    }
+  }
+
+  // Like VirtualChess::updateState, except the UI is redrawn every frame,
+  // as it is while a game clock is ticking
+  void updateState(const Scene & scene) {
+    if (scene.ui) {
+      uiFramebuffer.bind();
+      glClear(GL_COLOR_BUFFER_BIT);
+      GpuTimer::Scope timer("UI");
+      CEGUI::System::getSingleton().renderAllGUIContexts();
+      glDisable(GL_SCISSOR_TEST);
+    }
+    skybox.update();
+
+    for (size_t i = 0; i < boards.size(); ++i) {
+      if (0 == rand() % MOVE_RATE) {
+        randomMove(boards[i]);
+      }
+    }
+    Stacks::modelview().top() = baseView;
+    float pixelScale = PieceRenderer::getPixelScale(eyesArgs[ovrEye_Left].projection, EYE_SIZE.y);
+    if (scene.wall) {
+      for (size_t i = 0; i < boards.size(); ++i) {
+        wall.setBoard(i, boards[i]);
+      }
+      wall.update(pixelScale);
+    } else {
+      pieces.setBoard(boards[0]);
+      pieces.update(pixelScale);
+    }
+  }
+
+  // Like VirtualChess::drawScene
+  void drawScene(const Scene & scene) {
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    Uniforms::setLights(lights);
+    skybox.render();
+    MatrixStack & mv = Stacks::modelview();
+    if (scene.ui) {
+      static const ProgramHandle texturedProgram = GlUtils::getProgramHandle(
+        Resource::SHADERS_TEXTURED_VS, Resource::SHADERS_TEXTURED_FS);
+      mv.withPush([&]{
+        mv.translate(vec3(0, 0.35, -0.35f));
+        if (!Culling::isVisible(uiGeometry.bounds, mv.top())) {
+          return;
+        }
+        uiFramebuffer.color.Bind(Texture::Target::_2D);
+        Render::renderGeometry(GlUtils::getProgram(texturedProgram), uiGeometry);
+      });
+    }
+    GpuTimer::Scope timer("Board");
+    if (scene.wall) {
+      wall.render();
+    } else {
+      pieces.render();
+    }
+  }
+
+  // Like RiftApp::drawPerEye, with the eye poses at the origin
+  void drawPerEye(const Scene & scene) {
+    MatrixStack & mv = Stacks::modelview();
+    MatrixStack & pr = Stacks::projection();
+    glEnable(GL_SCISSOR_TEST);
+    for_each_eye([&](ovrEyeType eye){
+      const RiftApp::PerEyeArgs & eyeArgs = eyesArgs[eye];
+      pr.top() = eyeArgs.projection;
+      Stacks::with_push(pr, mv, [&]{
+        mv.top() = eyeArgs.viewAdjust * baseView;
+        Uniforms::setCamera(pr.top(), mv.top());
+        Culling::setViews(&pr.top(), 1);
+        glViewport(eyeArgs.viewportPosition.x, eyeArgs.viewportPosition.y,
+          eyeArgs.viewportSize.x, eyeArgs.viewportSize.y);
+        glScissor(eyeArgs.viewportPosition.x, eyeArgs.viewportPosition.y,
+          eyeArgs.viewportSize.x, eyeArgs.viewportSize.y);
+        drawScene(scene);
+      });
+    });
+    glDisable(GL_SCISSOR_TEST);
+  }
+
+  // Like RiftApp::drawSinglePass
+  void drawSinglePass(const Scene & scene) {
+    MatrixStack & mv = Stacks::modelview();
+    MatrixStack & pr = Stacks::projection();
+    mat4 projections[2];
+    mat4 views[2];
+    for_each_eye([&](ovrEyeType eye){
+      projections[eye] = eyesArgs[eye].projection;
+      views[eye] = eyesArgs[eye].viewAdjust * baseView;
+    });
+    pr.top() = projections[ovrEye_Left];
+    Stacks::with_push(pr, mv, [&]{
+      mv.top() = views[ovrEye_Left];
+      Uniforms::setStereoCamera(projections, views);
+      mat4 clips[2] = {
+        projections[ovrEye_Left],
+        projections[ovrEye_Right] * views[ovrEye_Right] * glm::inverse(views[ovrEye_Left])
+      };
+      Culling::setViews(clips, 2);
+      glViewport(0, 0, framebuffer.size.x, framebuffer.size.y);
+      glEnable(GL_CLIP_DISTANCE0);
+      drawScene(scene);
+      glDisable(GL_CLIP_DISTANCE0);
+    });
+  }
+
+  // Renders the scene for WARMUP_FRAMES + FRAMES frames, and reports the
+  // means over the last FRAMES.  Each frame is waited for, so the CPU
+  // time is only submission.
+  void timeScene(const Scene & scene, bool singlePass) {
+    Geometry::viewCount = singlePass ? 2 : 1;
+    boards.assign(scene.wall ? WALL_BOARDS : 1, Chess::Board());
+    if (scene.wall) {
+      wall.setBoardCount(boards.size());
+    }
+    srand(0);
+
+    GLuint query;
+    glGenQueries(1, &query);
+    int64_t cpuNanos = 0;
+    GLuint64 gpuNanos = 0;
+    uint64_t drawCalls = 0;
+    for (int i = 0; i < WARMUP_FRAMES + FRAMES; ++i) {
+      uint64_t startDraws = Geometry::drawCalls;
+      int64_t start = Platform::elapsedNanos();
+      glBeginQuery(GL_TIME_ELAPSED, query);
+      GpuTimer::beginFrame();
+      Uniforms::beginFrame();
+      updateState(scene);
+      framebuffer.bind();
+      if (singlePass) {
+        drawSinglePass(scene);
+      } else {
+        drawPerEye(scene);
+      }
+      DefaultFramebuffer().Bind(Framebuffer::Target::Draw);
+      glEndQuery(GL_TIME_ELAPSED);
+      int64_t end = Platform::elapsedNanos();
+      GLuint64 elapsed = 0;
+      glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+      if (i >= WARMUP_FRAMES) {
+        cpuNanos += end - start;
+        gpuNanos += elapsed;
+        drawCalls += Geometry::drawCalls - startDraws;
+      }
+    }
+    glDeleteQueries(1, &query);
+    Geometry::viewCount = 1;
+    GL_CHECK_ERROR;
+
+    SAY("%s, %s, %.1f, %.1f, %.1f", scene.name,
+      singlePass ? "single pass" : "per eye",
+      (double)cpuNanos / FRAMES / 1000.0,
+      (double)gpuNanos / FRAMES / 1000.0,
+      (double)drawCalls / FRAMES);
+  }
+
+  void onTick() {
+    static const Scene SCENES[] = {
+      { "board", false, false },
+      { "board + UI", false, true },
+      { "wall", true, false },
+      { "wall + UI", true, true },
+    };
+    SAY("scene, stereo, CPU submit (us/frame), GPU (us/frame), draw calls/frame");
+    for (const Scene & scene : SCENES) {
+      timeScene(scene, false);
+      timeScene(scene, true);
+    }
+    done = true;
+  }
+};
+
+RUN_APP(EglWrapperApp<VirtualChessBench>);
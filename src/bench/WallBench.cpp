@@ -0,0 +1,127 @@
+#include "Common.h"
+#include "bench/BenchApp.h"
+
+#pragma warning( disable : 4068 4244 4099 4305 4101)
+#include <oglplus/bound/texture.hpp>
+#include <oglplus/bound/framebuffer.hpp>
+#include <oglplus/bound/renderbuffer.hpp>
+#pragma warning( default : 4068 4244 4099 4305 4101)
+
+using namespace oglplus;
+
+// Compares the CPU cost of submitting a tournament wall with BoardWall's
+// single multi-draw against one PieceRenderer per board.  The GPU is
+// drained outside the timed region, so only submission is measured.
+class WallBench {
+  static const int WARMUP_FRAMES = 30;
+  static const int FRAMES = 300;
+  // Each frame, one in this many boards gets a new move
+  static const int MOVE_RATE = 20;
+
+  BenchFramebuffer framebuffer{ uvec2(1182, 1464) };
+  std::vector<Chess::Board> boards;
+  Lights lights;
+  bool done{ false };
+
+public:
+  WallBench(const uvec2 &) {
+    MatrixStack & pr = Stacks::projection();
+    pr.top() = glm::perspective(PI / 2.0f, 1182.0f / 1464.0f, 0.01f, 100.0f);
+    Stacks::modelview().top() = glm::lookAt(vec3(0, 0, 0), vec3(0, 0, -1), GlUtils::Y_AXIS);
+    glEnable(GL_DEPTH_TEST);
+  }
+
+  bool isDone() {
+    return done;
+  }
+
+  // Moves a random piece to a random empty square.  The result is rarely
+  // a legal position, but it changes the board like a move does.
+  static void randomMove(Chess::Board & board) {
+    for (int tries = 0; tries < 64; ++tries) {
+      int fromRow = rand() % 8, fromCol = rand() % 8;
+      int toRow = rand() % 8, toCol = rand() % 8;
+      Chess::Piece & from = board.position[fromRow][fromCol];
+      Chess::Piece & to = board.position[toRow][toCol];
+      if (from && !to) {
+        std::swap(from, to);
+        return;
+      }
+    }
+  }
+
+  void playMoves() {
+    for (size_t i = 0; i < boards.size(); ++i) {
+      if (0 == rand() % MOVE_RATE) {
+        randomMove(boards[i]);
+      }
+    }
+  }
+
+  // Returns the mean submission time per frame, in microseconds
+  template <typename Function>
+  double timeFrames(Function frame) {
+    int64_t total = 0;
+    srand(0);
+    for (int i = 0; i < WARMUP_FRAMES + FRAMES; ++i) {
+      playMoves();
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      int64_t start = Platform::elapsedNanos();
+      Uniforms::beginFrame();
+      Uniforms::setCamera(Stacks::projection().top(), Stacks::modelview().top());
+      Uniforms::setLights(lights);
+      frame();
+      int64_t end = Platform::elapsedNanos();
+      glFinish();
+      if (i >= WARMUP_FRAMES) {
+        total += end - start;
+      }
+    }
+    return (double)total / FRAMES / 1000.0;
+  }
+
+  double timeWall() {
+    BoardWall wall;
+    wall.setBoardCount(boards.size());
+    return timeFrames([&]{
+      for (size_t i = 0; i < boards.size(); ++i) {
+        wall.setBoard(i, boards[i]);
+      }
+      wall.update(PieceRenderer::getPixelScale(Stacks::projection().top(), framebuffer.size.y));
+      wall.render();
+    });
+  }
+
+  double timePerBoard() {
+    // Same arrangement as the wall, so both draw the same pixels
+    std::vector<PieceRenderer> renderers(boards.size());
+    MatrixStack & mv = Stacks::modelview();
+    float pixelScale = PieceRenderer::getPixelScale(Stacks::projection().top(), framebuffer.size.y);
+    return timeFrames([&]{
+      for (size_t i = 0; i < boards.size(); ++i) {
+        mv.withPush([&]{
+          mv.postMultiply(BoardWall::getBoardTransform(i, boards.size()));
+          renderers[i].setBoard(boards[i]);
+          renderers[i].update(pixelScale);
+          renderers[i].render();
+        });
+      }
+    });
+  }
+
+  void onTick() {
+    framebuffer.bind();
+    SAY("boards, multi-draw (us/frame), per board (us/frame), speedup");
+    for (int count = 1; count <= BoardWall::MAX_BOARDS; count *= 2) {
+      boards.assign(count, Chess::Board());
+      double wallTime = timeWall();
+      boards.assign(count, Chess::Board());
+      double perBoardTime = timePerBoard();
+      SAY("%d, %.1f, %.1f, %.2f", count, wallTime, perBoardTime, perBoardTime / wallTime);
+    }
+    DefaultFramebuffer().Bind(Framebuffer::Target::Draw);
+    done = true;
+  }
+};
+
+RUN_APP(BenchWrapperApp<WallBench>);